@@ -1,3 +1,23 @@
 QT += core gui
 CONFIG += console c++17
-SOURCES += main.cpp
+# main.cpp lee las opciones y elige el modo; cada modo y cada pieza de la aplicación en su archivo
+SOURCES += main.cpp \
+    lote.cpp \
+    servicio.cpp \
+    generador.cpp \
+    benchmark.cpp \
+    caso.cpp \
+    imagenes.cpp \
+    bmp.cpp \
+    memoria.cpp \
+    mascaras.cpp \
+    cache_resultados.cpp \
+    perfil.cpp
+HEADERS += aplicacion.h
+include(reconstruccion.pri)
+
+# Sin QtGui: solo se leen BMP de 24 bits con el lector nativo (qmake CONFIG+=sin_qtgui)
+sin_qtgui {
+    QT -= gui
+    DEFINES += SIN_QTGUI
+}
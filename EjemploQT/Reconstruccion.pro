@@ -0,0 +1,6 @@
+# Biblioteca estática con la API en memoria: no enlaza Qt ni lee archivos
+TEMPLATE = lib
+TARGET = reconstruccion
+CONFIG += staticlib c++17
+CONFIG -= qt
+include(reconstruccion.pri)
@@ -0,0 +1,293 @@
+#ifndef APLICACION_H
+#define APLICACION_H
+
+// Piezas de la aplicación de línea de comandos que comparten sus módulos: carga y escritura de
+// imágenes y máscaras, el caso completo (reconstruirImagen), el modo por bloques, la caché de
+// resultados, el generador, el benchmark y el servicio. main.cpp solo lee las opciones y elige
+// el modo; el cálculo está en la biblioteca (reconstruccion.h).
+
+#include <QFile>
+#include <QString>
+#include <QStringList>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "reconstruccion_interna.h"
+
+// Contenido de un archivo de enmascaramiento Mk.txt cargado del disco. Los valores viven en
+// 'almacen' si se parsearon del .txt, o directamente en la proyección del .mskbin.
+struct DatosMascara : RestriccionMascara {
+    std::vector<uint16_t> almacen;
+    std::unique_ptr<QFile> archivoProyectado;
+};
+
+// Reserva de buffers reutilizables. Cada hilo de trabajo tiene la suya (poolDelHilo), de modo
+// que los buffers de un caso se reutilizan en el siguiente sin volver a pedir memoria.
+class PoolBuffers {
+public:
+    ~PoolBuffers();
+    unsigned char* adquirir(size_t tamano);
+    void liberar(unsigned char* buffer);
+    size_t bytesReservados() const { return totalReservado; }
+
+private:
+    struct Bloque {
+        unsigned char* datos;
+        size_t capacidad;
+        bool enUso;
+        bool proyectado;  // Pedido con mmap (buffers grandes) en lugar de new[]
+    };
+    // Memoria que se retiene en bloques libres entre un caso y el siguiente, por hilo
+    static const size_t MAX_BYTES_LIBRES = (size_t)512 << 20;
+
+    std::vector<Bloque> bloques;
+    size_t totalReservado = 0;
+};
+
+// Buffer prestado por un PoolBuffers que se devuelve solo al salir de su ámbito
+class BufferPrestado {
+public:
+    BufferPrestado(PoolBuffers& pool, unsigned char* datos) : pool(pool), datos(datos) {}
+    BufferPrestado(PoolBuffers& pool, size_t tamano) : pool(pool), datos(pool.adquirir(tamano)) {}
+    ~BufferPrestado() { pool.liberar(datos); }
+    BufferPrestado(const BufferPrestado&) = delete;
+    BufferPrestado& operator=(const BufferPrestado&) = delete;
+
+    unsigned char* get() const { return datos; }
+    operator unsigned char*() const { return datos; }
+    void intercambiar(BufferPrestado& otro) { std::swap(datos, otro.datos); }
+
+private:
+    PoolBuffers& pool;
+    unsigned char* datos;
+};
+
+// Contadores de la reconstrucción de un caso, para el benchmark y los informes
+struct EstadisticasCaso {
+    int ancho = 0;
+    int alto = 0;
+    int pasos = 0;
+    bool secuenciaCompleta = false;
+    int volcadosDescartados = 0;            // Imágenes de diagnóstico que no entraron en la cola
+    long estados = 0;
+    long candidatosVerificados = 0;
+    long candidatosDescartados = 0;
+    double msBusqueda = 0;
+    std::vector<Transformacion> secuencia;  // Del primer al último paso; NINGUNA si no se identificó
+};
+
+// Eventos de todos los casos para el archivo de --traza (formato trace_event de Chrome,
+// se abre en chrome://tracing o en Perfetto). Los casos se agregan al terminar, desde
+// cualquier hilo.
+class RegistroTraza {
+public:
+    void agregar(const QString& caso, const Perfilador& perfilador);
+    bool escribir(const QString& archivo);
+
+private:
+    std::mutex mtx;
+    std::vector<std::string> eventos;
+};
+
+// Qué imágenes intermedias se vuelcan a disco para depuración
+enum NivelDiagnostico {
+    DIAGNOSTICO_NINGUNO,   // Solo la imagen reconstruida final
+    DIAGNOSTICO_ACEPTADOS, // Además, la imagen de cada paso aceptado
+    DIAGNOSTICO_TODOS      // Además, cada candidato probado
+};
+
+// Volcados de diagnóstico encolados por un caso. El escritor anota lo que no pudo escribir (con
+// su mensaje de error); el caso no espera a que se escriban: al terminar los cierra y el
+// escritor llama a alTerminar desde su hilo cuando escribió el último.
+struct VolcadosCaso {
+    int pendientes = 0;
+    int descartados = 0;
+    int fallidos = 0;
+    std::vector<std::string> errores;
+    bool cerrado = false;  // El caso ya no encola más
+    std::function<void(const VolcadosCaso&)> alTerminar;
+};
+
+// Escritor de imágenes en segundo plano. El hilo que resuelve solo copia los píxeles a la
+// cola; un hilo aparte los codifica y escribe. La cola tiene un límite de memoria: si se
+// llena, el que encola espera a que se libere lugar. Solo los volcados marcados como
+// descartables (cada candidato probado, --diagnostico todos) se descartan en lugar de esperar.
+// Los errores de escritura no salen por cout (en --servicio es la salida de las respuestas):
+// van a los VolcadosCaso del caso, o a cerr si la imagen no tiene caso.
+class EscritorAsincrono {
+public:
+    explicit EscritorAsincrono(size_t limiteBytes);
+    ~EscritorAsincrono(); // Termina de escribir lo pendiente antes de salir
+    bool encolar(const unsigned char* pixeles, int ancho, int alto, const QString& archivo,
+                 const std::shared_ptr<VolcadosCaso>& volcados = nullptr, bool descartable = false);
+    // El caso ya no encola más: alTerminar se llama cuando se escriba el último volcado (en el
+    // acto si no queda ninguno)
+    void cerrar(const std::shared_ptr<VolcadosCaso>& volcados, std::function<void(const VolcadosCaso&)> alTerminar);
+    void esperar(); // Bloquea hasta que se escriba todo lo encolado y terminen los avisos de los casos
+    int descartadas() const { return imagenesDescartadas; }
+    int fallidas() const { return imagenesFallidas; }
+
+private:
+    struct Pendiente {
+        std::vector<unsigned char> pixeles;
+        int ancho;
+        int alto;
+        QString archivo;
+        std::shared_ptr<VolcadosCaso> volcados;  // Compartido: el caso puede terminar antes que el escritor
+    };
+    void bucleEscritura();
+
+    std::thread hilo;
+    std::queue<Pendiente> cola;
+    std::mutex mtx;
+    std::condition_variable hayTrabajo;
+    std::condition_variable imagenEscrita;
+    size_t limiteBytes;
+    size_t bytesEnCola = 0;
+    int enCurso = 0;  // Encoladas y todavía sin escribir (o sin avisar a su caso)
+    std::atomic<int> imagenesDescartadas{0};
+    std::atomic<int> imagenesFallidas{0};
+    bool detener = false;
+};
+
+// Datos de la cabecera de un BMP de 24 bits sin compresión
+struct CabeceraBmp {
+    int ancho = 0;
+    int alto = 0;
+    bool abajoArriba = true;    // Alto positivo en el archivo: filas de abajo hacia arriba
+    long long inicioPixeles = 0;
+    long long pasoFila = 0;     // Bytes por fila, con el relleno a múltiplo de 4
+};
+
+// Lectura de un BMP por bloques de filas (modo --por-bloques). Un hilo lee el bloque siguiente
+// mientras se procesa el actual, así la lectura se solapa con el cálculo y nunca hay más de
+// dos bloques en memoria.
+class LectorBmpPorBloques {
+public:
+    ~LectorBmpPorBloques() { detenerLectura(); }
+    bool abrir(const QString& ruta);
+    const CabeceraBmp& cabecera() const { return info; }
+    void iniciar(int filas);  // Empieza (o vuelve a empezar) desde la fila de arriba
+    // Siguiente bloque en RGB, de arriba hacia abajo; nullptr al terminar o si falla la lectura
+    const unsigned char* siguiente(int& primeraFila, int& filas);
+    bool fallo() const { return error; }
+
+private:
+    void detenerLectura();
+    void bucleLectura();
+
+    QFile archivo;
+    CabeceraBmp info;
+    int filasPorBloque = 0;
+    int totalBloques = 0;
+    std::vector<unsigned char> buffers[2];
+    std::vector<unsigned char> crudo;  // Filas tal como están en el archivo (BGR con relleno)
+    std::thread hilo;
+    std::mutex mtx;
+    std::condition_variable cambio;
+    int leidos = 0;      // Bloques ya cargados en su buffer
+    int entregados = 0;  // Bloques devueltos por siguiente()
+    bool detener = false;
+    std::atomic<bool> error{false};
+};
+
+// Escritura de un BMP por bloques de filas: cada bloque se escribe directamente en su lugar
+class EscritorBmpPorBloques {
+public:
+    bool abrir(const QString& ruta, int ancho, int alto);
+    bool escribir(const unsigned char* pixeles, int primeraFila, int filas);  // RGB, de arriba hacia abajo
+
+private:
+    QFile archivo;
+    int ancho = 0;
+    int alto = 0;
+    long long pasoFila = 0;
+    std::vector<unsigned char> crudo;
+};
+
+// Parámetros del generador de casos (--generar)
+struct ParametrosGenerador {
+    QString dirCaso;
+    QString imagenOrigen;                   // --origen (vacío = imagen aleatoria de ancho x alto)
+    QString imagenMascara;                  // --mascara (vacío = M.bmp aleatoria de 10x10)
+    int ancho = 1920;                       // --tamano ANCHOxALTO
+    int alto = 1080;
+    int pasos = 7;                          // --pasos N
+    unsigned int semilla = 1;               // --semilla N
+    std::vector<Transformacion> secuencia;  // Vacía = secuencia aleatoria de 'pasos' pasos
+    int hilos = 0;                          // 0 = todos los núcleos
+};
+
+// Opciones de línea de comandos
+struct OpcionesEjecucion {
+    int hilos = 0; // --jobs N (0 = todos los núcleos disponibles)
+    NivelDiagnostico diagnostico = DIAGNOSTICO_ACEPTADOS; // --diagnostico ninguno|aceptados|todos
+    int memoriaDiagnosticoMB = 256; // --diagnostico-memoria MB, límite de la cola de escritura
+    QString simd; // --simd escalar|sse2|avx2|avx512 (vacío = el mejor disponible)
+    bool cacheMascaras = false; // --cache-mascaras: escribir Mk.mskbin junto a cada Mk.txt
+    QString benchmark; // --benchmark ARCHIVO.json ("-" = salida estándar)
+    ParametrosGenerador generador; // --generar DIR y sus parámetros
+    bool perfil = false; // --perfil: perfil.json con fases y contadores en la salida de cada caso
+    QString traza; // --traza ARCHIVO: fases de todos los casos en formato trace_event de Chrome
+    bool porBloques = false; // --por-bloques: recorrer las imágenes por bloques sin cargarlas completas
+    bool servicio = false; // --servicio: atender casos leídos de la entrada estándar hasta EOF
+    int hilosCaso = 0; // --hilos-caso N: hilos dentro de cada caso (0 = los que sobran tras repartir los casos)
+    QString cacheResultados; // --cache-resultados DIR: secuencias ya resueltas, por contenido del caso
+    bool cacheVerificar = false; // --cache-verificar: comprobar contra las máscaras lo que sale de la caché
+    bool cacheImagenes = false; // --cache-imagenes: guardar también la imagen reconstruida en la caché
+    int cacheMaxMB = 1024; // --cache-max-mb MB: tamaño máximo de la caché antes de descartar lo más viejo
+    QString memoriaDisco; // --memoria-disco DIR: respaldar los buffers grandes en archivos temporales de DIR
+};
+
+// Modos de la línea de comandos (lote.cpp, servicio.cpp, generador.cpp, benchmark.cpp)
+int ejecutarLote(OpcionesEjecucion opciones);
+int ejecutarServicio(const OpcionesEjecucion& opciones);
+bool generarCaso(const ParametrosGenerador& parametros);
+int ejecutarBenchmark(const OpcionesEjecucion& opciones);
+
+// Un caso completo (caso.cpp)
+bool reconstruirImagen(const QString& casoDirectorio, const QString& dirSalida,
+const OpcionesEjecucion& opciones, EscritorAsincrono& escritor, EstadisticasCaso* estadisticas = nullptr,
+const std::function<void(const VolcadosCaso&)>& alTerminarVolcados = nullptr);
+bool analizarPorBloques(LectorBmpPorBloques& lectorFinal, LectorBmpPorBloques& lectorAuxiliar, const CasoEnMemoria& caso,
+std::vector<std::vector<unsigned char>>& ventanasFinal, std::vector<std::vector<unsigned char>>& ventanasAuxiliar, uint64_t* histograma);
+bool reconstruirPorBloques(LectorBmpPorBloques& lectorFinal, LectorBmpPorBloques& lectorAuxiliar,
+const std::vector<std::pair<TransformacionCompuesta, QString>>& salidas);
+void registrarSecuencia(const std::vector<Transformacion>& secuencia);
+
+// Imágenes (imagenes.cpp, bmp.cpp) y buffers (memoria.cpp)
+unsigned char* cargarImagen(QString archivo, int &ancho, int &alto, PoolBuffers* pool = nullptr);
+bool guardarImagen(unsigned char* pixeles, int ancho, int alto, QString archivo);
+unsigned char* cargarBmpNativo(const QString& archivo, int &ancho, int &alto, PoolBuffers* pool = nullptr);
+bool guardarBmpNativo(const unsigned char* pixeles, int ancho, int alto, const QString& archivo);
+PoolBuffers& poolDelHilo();
+void establecerMemoriaDisco(const std::string& directorio);  // --memoria-disco (vacío = memoria anónima)
+
+// Máscaras (mascaras.cpp)
+bool cargarDatosEnmascaramiento(const QString& archivo, DatosMascara& datos, bool guardarCacheBinaria = false);
+bool verificarEnmascaramiento(unsigned char* imagen, int anchoImagen, int altoImagen,
+const QString& archivoMascara, const QString& rutaSalida);
+bool reemplazarArchivo(const QString& origen, const QString& destino);  // rename que pisa el destino
+
+// Caché de resultados (cache_resultados.cpp)
+uint64_t hashXX64(const unsigned char* datos, size_t largo, uint64_t semilla);
+QString claveCaso(const QStringList& archivos);
+bool leerResultadoCache(const QString& dirCache, const QString& clave, std::vector<Transformacion>& secuencia, bool& completa);
+void guardarResultadoCache(const QString& dirCache, const QString& clave, const std::vector<Transformacion>& secuencia,
+bool completa, const QString& imagenReconstruida, long long limiteBytes);
+
+// Informes (perfil.cpp)
+std::string textoJson(const std::string& texto);
+bool guardarResumenPerfil(const Perfilador& perfilador, const QString& archivo, const QString& caso, bool exito,
+const EstadisticasCaso& estadisticas);
+extern RegistroTraza trazaGlobal;  // Eventos acumulados para --traza
+
+#endif // APLICACION_H
@@ -0,0 +1,246 @@
+// BMP de 24 bits sin Qt: lectura y escritura de la imagen completa y por bloques de filas
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+
+#include "aplicacion.h"
+
+using namespace std;
+
+// Cabeceras BMP (BITMAPFILEHEADER + BITMAPINFOHEADER): 54 bytes, todo en little endian
+static const int TAMANO_CABECERA_BMP = 54;
+
+static uint32_t leerU32(const unsigned char* p) { return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24); }
+static uint16_t leerU16(const unsigned char* p) { return p[0] | (p[1] << 8); }
+static void escribirU32(unsigned char* p, uint32_t v) { p[0] = v; p[1] = v >> 8; p[2] = v >> 16; p[3] = v >> 24; }
+static void escribirU16(unsigned char* p, uint16_t v) { p[0] = v; p[1] = v >> 8; }
+
+static bool leerCabeceraBmp(const unsigned char* datos, long long tamanoArchivo, CabeceraBmp& cabecera) {
+    if (tamanoArchivo < TAMANO_CABECERA_BMP || datos[0] != 'B' || datos[1] != 'M') return false;
+    uint32_t inicioPixeles = leerU32(datos + 10);
+    uint32_t tamanoInfo = leerU32(datos + 14);
+    int32_t anchoBmp = (int32_t)leerU32(datos + 18);
+    int32_t altoBmp = (int32_t)leerU32(datos + 22);
+    uint16_t planos = leerU16(datos + 26);
+    uint16_t bitsPorPixel = leerU16(datos + 28);
+    uint32_t compresion = leerU32(datos + 30);
+    if (tamanoInfo < 40 || planos != 1 || bitsPorPixel != 24 || compresion != 0) return false;
+
+    // Alto positivo: filas de abajo hacia arriba. Negativo: de arriba hacia abajo.
+    bool abajoArriba = altoBmp > 0;
+    long long altoAbs = abajoArriba ? altoBmp : -(long long)altoBmp;
+    if (anchoBmp <= 0 || altoAbs <= 0) return false;
+
+    // Cada fila ocupa un múltiplo de 4 bytes
+    long long bytesFila = (long long)anchoBmp * 3;
+    long long pasoFila = (bytesFila + 3) & ~3LL;
+    if ((long long)inicioPixeles + pasoFila * altoAbs > tamanoArchivo) return false;
+
+    cabecera.ancho = anchoBmp;
+    cabecera.alto = (int)altoAbs;
+    cabecera.abajoArriba = abajoArriba;
+    cabecera.inicioPixeles = inicioPixeles;
+    cabecera.pasoFila = pasoFila;
+    return true;
+}
+
+static void escribirCabeceraBmp(unsigned char* datos, int ancho, int alto, long long pasoFila) {
+    long long tamanoArchivo = TAMANO_CABECERA_BMP + pasoFila * alto;
+    memset(datos, 0, TAMANO_CABECERA_BMP);
+    datos[0] = 'B';
+    datos[1] = 'M';
+    // Los campos de tamaño son de 32 bits: en un BMP de más de 4 GB se dejan en cero (los
+    // lectores calculan el tamaño con el ancho y el alto)
+    escribirU32(datos + 2, tamanoArchivo > UINT32_MAX ? 0 : (uint32_t)tamanoArchivo);
+    escribirU32(datos + 10, TAMANO_CABECERA_BMP);
+    escribirU32(datos + 14, 40);
+    escribirU32(datos + 18, ancho);
+    escribirU32(datos + 22, alto);
+    escribirU16(datos + 26, 1);
+    escribirU16(datos + 28, 24);
+    escribirU32(datos + 34, tamanoArchivo > UINT32_MAX ? 0 : (uint32_t)(pasoFila * alto));
+    escribirU32(datos + 38, 2835);  // 72 ppp, como QImage
+    escribirU32(datos + 42, 2835);
+}
+
+unsigned char* cargarBmpNativo(const QString& archivo, int &ancho, int &alto, PoolBuffers* pool) {
+    // Lector directo para BMP de 24 bits sin compresión: se proyecta el archivo en memoria y
+    // cada fila se copia (pasando de BGR a RGB) directamente al buffer final. Devuelve nullptr
+    // sin mensaje si el archivo es de otro formato, para que se pueda usar QImage en su lugar.
+    QFile f(archivo);
+    if (!f.open(QIODevice::ReadOnly) || f.size() < TAMANO_CABECERA_BMP) return nullptr;
+    long long tamanoArchivo = f.size();
+    const unsigned char* datos = f.map(0, tamanoArchivo);
+    if (!datos) return nullptr;
+
+    CabeceraBmp cabecera;
+    if (!leerCabeceraBmp(datos, tamanoArchivo, cabecera)) return nullptr;
+
+    ancho = cabecera.ancho;
+    alto = cabecera.alto;
+    size_t tamano = (size_t)ancho * alto * 3;
+    unsigned char* pixeles = pool ? pool->adquirir(tamano) : new unsigned char[tamano];
+    for (int y = 0; y < alto; y++) {
+        const unsigned char* fila = datos + cabecera.inicioPixeles +
+                                    cabecera.pasoFila * (cabecera.abajoArriba ? alto - 1 - y : y);
+        unsigned char* destino = pixeles + (size_t)y * ancho * 3;
+        for (int x = 0; x < ancho * 3; x += 3) {
+            destino[x] = fila[x + 2];
+            destino[x + 1] = fila[x + 1];
+            destino[x + 2] = fila[x];
+        }
+    }
+    return pixeles;
+}
+
+bool guardarBmpNativo(const unsigned char* pixeles, int ancho, int alto, const QString& archivo) {
+    // Se reserva el archivo con su tamaño final, se proyecta y cada fila se escribe en su lugar
+    // (RGB a BGR, de abajo hacia arriba, con el relleno a 4 bytes)
+    long long bytesFila = (long long)ancho * 3;
+    long long pasoFila = (bytesFila + 3) & ~3LL;
+    long long tamanoArchivo = TAMANO_CABECERA_BMP + pasoFila * alto;
+
+    QFile f(archivo);
+    if (!f.open(QIODevice::ReadWrite | QIODevice::Truncate) || !f.resize(tamanoArchivo)) return false;
+    unsigned char* datos = f.map(0, tamanoArchivo);
+    if (!datos) return false;
+
+    escribirCabeceraBmp(datos, ancho, alto, pasoFila);
+
+    for (int y = 0; y < alto; y++) {
+        const unsigned char* origen = pixeles + (size_t)y * ancho * 3;
+        unsigned char* fila = datos + TAMANO_CABECERA_BMP + pasoFila * (alto - 1 - y);
+        for (int x = 0; x < ancho * 3; x += 3) {
+            fila[x] = origen[x + 2];
+            fila[x + 1] = origen[x + 1];
+            fila[x + 2] = origen[x];
+        }
+        memset(fila + bytesFila, 0, pasoFila - bytesFila);
+    }
+    return true;
+}
+
+bool LectorBmpPorBloques::abrir(const QString& ruta)
+{
+    detenerLectura();
+    archivo.close();
+    archivo.setFileName(ruta);
+    unsigned char cabecera[TAMANO_CABECERA_BMP];
+    return archivo.open(QIODevice::ReadOnly) &&
+           archivo.read((char*)cabecera, TAMANO_CABECERA_BMP) == TAMANO_CABECERA_BMP &&
+           leerCabeceraBmp(cabecera, archivo.size(), info);
+}
+
+void LectorBmpPorBloques::iniciar(int filas)
+{
+    detenerLectura();
+    filasPorBloque = max(1, min(filas, info.alto));
+    totalBloques = (info.alto + filasPorBloque - 1) / filasPorBloque;
+    for (vector<unsigned char>& b : buffers) b.resize((size_t)filasPorBloque * info.ancho * 3);
+    crudo.resize((size_t)filasPorBloque * info.pasoFila);
+    leidos = entregados = 0;
+    detener = false;
+    error = false;
+    hilo = thread([this]() { bucleLectura(); });
+}
+
+void LectorBmpPorBloques::detenerLectura()
+{
+    if (!hilo.joinable()) return;
+    {
+        lock_guard<mutex> lock(mtx);
+        detener = true;
+    }
+    cambio.notify_all();
+    hilo.join();
+}
+
+void LectorBmpPorBloques::bucleLectura()
+{
+    for (int bloque = 0; bloque < totalBloques; bloque++) {
+        {
+            // Hay dos buffers: el bloque k se lee cuando ya se terminó de usar el k - 2
+            unique_lock<mutex> lock(mtx);
+            cambio.wait(lock, [&]() { return detener || bloque <= entregados; });
+            if (detener) return;
+        }
+
+        int primeraFila = bloque * filasPorBloque;
+        int filas = min(filasPorBloque, info.alto - primeraFila);
+        // Las filas del bloque son contiguas en el archivo; de abajo hacia arriba, en orden inverso
+        int primeraEnArchivo = info.abajoArriba ? info.alto - primeraFila - filas : primeraFila;
+        long long bytes = info.pasoFila * filas;
+        if (!archivo.seek(info.inicioPixeles + info.pasoFila * primeraEnArchivo) ||
+            archivo.read((char*)crudo.data(), bytes) != bytes) {
+            error = true;
+        }
+
+        unsigned char* destino = buffers[bloque % 2].data();
+        for (int y = 0; y < filas && !error; y++) {
+            int filaArchivo = info.abajoArriba ? filas - 1 - y : y;
+            const unsigned char* fila = crudo.data() + info.pasoFila * filaArchivo;
+            unsigned char* salida = destino + (size_t)y * info.ancho * 3;
+            for (int x = 0; x < info.ancho * 3; x += 3) {
+                salida[x] = fila[x + 2];
+                salida[x + 1] = fila[x + 1];
+                salida[x + 2] = fila[x];
+            }
+        }
+        {
+            lock_guard<mutex> lock(mtx);
+            leidos = bloque + 1;
+        }
+        cambio.notify_all();
+        if (error) return;
+    }
+}
+
+const unsigned char* LectorBmpPorBloques::siguiente(int& primeraFila, int& filas)
+{
+    // Pedir un bloque nuevo libera el anterior: su buffer queda disponible para el lector
+    unique_lock<mutex> lock(mtx);
+    if (entregados >= totalBloques) return nullptr;
+    cambio.wait(lock, [&]() { return leidos > entregados || error; });
+    if (error) return nullptr;
+
+    int bloque = entregados++;
+    cambio.notify_all();
+    primeraFila = bloque * filasPorBloque;
+    filas = min(filasPorBloque, info.alto - primeraFila);
+    contarPerfil(CONTADOR_BYTES_ES, info.pasoFila * filas);  // Aquí: el perfilador es del hilo del caso
+    return buffers[bloque % 2].data();
+}
+
+bool EscritorBmpPorBloques::abrir(const QString& ruta, int anchoImagen, int altoImagen)
+{
+    ancho = anchoImagen;
+    alto = altoImagen;
+    pasoFila = ((long long)ancho * 3 + 3) & ~3LL;
+    unsigned char cabecera[TAMANO_CABECERA_BMP];
+    escribirCabeceraBmp(cabecera, ancho, alto, pasoFila);
+
+    archivo.setFileName(ruta);
+    return archivo.open(QIODevice::ReadWrite | QIODevice::Truncate) &&
+           archivo.resize(TAMANO_CABECERA_BMP + pasoFila * alto) &&
+           archivo.write((const char*)cabecera, TAMANO_CABECERA_BMP) == TAMANO_CABECERA_BMP;
+}
+
+bool EscritorBmpPorBloques::escribir(const unsigned char* pixeles, int primeraFila, int filas)
+{
+    // El archivo se guarda de abajo hacia arriba: el bloque ocupa un tramo contiguo con las
+    // filas en orden inverso
+    crudo.assign((size_t)pasoFila * filas, 0);
+    for (int y = 0; y < filas; y++) {
+        const unsigned char* origen = pixeles + (size_t)y * ancho * 3;
+        unsigned char* fila = crudo.data() + pasoFila * (filas - 1 - y);
+        for (int x = 0; x < ancho * 3; x += 3) {
+            fila[x] = origen[x + 2];
+            fila[x + 1] = origen[x + 1];
+            fila[x + 2] = origen[x];
+        }
+    }
+    long long inicio = TAMANO_CABECERA_BMP + pasoFila * (alto - primeraFila - filas);
+    contarPerfil(CONTADOR_BYTES_ES, (long long)crudo.size());
+    return archivo.seek(inicio) && archivo.write((const char*)crudo.data(), crudo.size()) == (long long)crudo.size();
+}
@@ -0,0 +1,195 @@
+// Caché de resultados (--cache-resultados): la secuencia de cada caso, por contenido
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QFileInfo>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#include "aplicacion.h"
+
+using namespace std;
+
+// XXH64 (el xxHash de 64 bits): rápido, sin dependencias y con buena dispersión, suficiente
+// para identificar el contenido de un caso (no es un hash criptográfico)
+static const uint64_t PRIMO64_1 = 0x9E3779B185EBCA87ULL;
+static const uint64_t PRIMO64_2 = 0xC2B2AE3D27D4EB4FULL;
+static const uint64_t PRIMO64_3 = 0x165667B19E3779F9ULL;
+static const uint64_t PRIMO64_4 = 0x85EBCA77C2B2AE63ULL;
+static const uint64_t PRIMO64_5 = 0x27D4EB2F165667C5ULL;
+
+static inline uint64_t rotarIzquierda64(uint64_t valor, int bits) { return (valor << bits) | (valor >> (64 - bits)); }
+static inline uint64_t leerU64(const unsigned char* p) { uint64_t v; memcpy(&v, p, 8); return v; }  // Little endian
+static inline uint64_t leerU32Hash(const unsigned char* p) { uint32_t v; memcpy(&v, p, 4); return v; }
+
+static inline uint64_t rondaXX64(uint64_t acumulado, uint64_t entrada) {
+    acumulado += entrada * PRIMO64_2;
+    return rotarIzquierda64(acumulado, 31) * PRIMO64_1;
+}
+
+static inline uint64_t mezclarXX64(uint64_t acumulado, uint64_t valor) {
+    acumulado ^= rondaXX64(0, valor);
+    return acumulado * PRIMO64_1 + PRIMO64_4;
+}
+
+uint64_t hashXX64(const unsigned char* datos, size_t largo, uint64_t semilla) {
+    const unsigned char* p = datos;
+    const unsigned char* fin = datos + largo;
+    uint64_t h;
+
+    if (largo >= 32) {
+        uint64_t v1 = semilla + PRIMO64_1 + PRIMO64_2;
+        uint64_t v2 = semilla + PRIMO64_2;
+        uint64_t v3 = semilla;
+        uint64_t v4 = semilla - PRIMO64_1;
+        for (; p + 32 <= fin; p += 32) {
+            v1 = rondaXX64(v1, leerU64(p));
+            v2 = rondaXX64(v2, leerU64(p + 8));
+            v3 = rondaXX64(v3, leerU64(p + 16));
+            v4 = rondaXX64(v4, leerU64(p + 24));
+        }
+        h = rotarIzquierda64(v1, 1) + rotarIzquierda64(v2, 7) + rotarIzquierda64(v3, 12) + rotarIzquierda64(v4, 18);
+        h = mezclarXX64(h, v1);
+        h = mezclarXX64(h, v2);
+        h = mezclarXX64(h, v3);
+        h = mezclarXX64(h, v4);
+    } else {
+        h = semilla + PRIMO64_5;
+    }
+    h += largo;
+
+    for (; p + 8 <= fin; p += 8) {
+        h ^= rondaXX64(0, leerU64(p));
+        h = rotarIzquierda64(h, 27) * PRIMO64_1 + PRIMO64_4;
+    }
+    if (p + 4 <= fin) {
+        h ^= leerU32Hash(p) * PRIMO64_1;
+        h = rotarIzquierda64(h, 23) * PRIMO64_2 + PRIMO64_3;
+        p += 4;
+    }
+    for (; p < fin; p++) {
+        h ^= *p * PRIMO64_5;
+        h = rotarIzquierda64(h, 11) * PRIMO64_1;
+    }
+
+    h ^= h >> 33;
+    h *= PRIMO64_2;
+    h ^= h >> 29;
+    h *= PRIMO64_3;
+    h ^= h >> 32;
+    return h;
+}
+
+QString claveCaso(const QStringList& archivos) {
+    // Hash encadenado del nombre y el contenido de cada archivo, en el orden dado (el nombre
+    // importa: M3.txt restringe un paso distinto que M4.txt). Vacía si alguno no se puede leer.
+    const uint64_t VERSION_CACHE = 1;  // Cambiarla invalida todas las entradas anteriores
+    uint64_t h = hashXX64((const unsigned char*)&VERSION_CACHE, sizeof(VERSION_CACHE), 0);
+    for (const QString& ruta : archivos) {
+        string nombre = QFileInfo(ruta).fileName().toStdString();
+        h = hashXX64((const unsigned char*)nombre.data(), nombre.size(), h);
+
+        QFile archivo(ruta);
+        if (!archivo.open(QIODevice::ReadOnly)) return QString();
+        long long tamano = archivo.size();
+        const unsigned char* datos = tamano > 0 ? archivo.map(0, tamano) : nullptr;
+        if (tamano > 0 && !datos) return QString();
+        h = hashXX64(datos, (size_t)tamano, h);
+        contarPerfil(CONTADOR_BYTES_ES, tamano);
+    }
+
+    char texto[17];
+    snprintf(texto, sizeof(texto), "%016llx", (unsigned long long)h);
+    return QString(texto);
+}
+
+static bool leerNombreTransformacion(const string& nombre, Transformacion& trans) {
+    // Inversa de nombreTransformacion ("xor", "rotacion_derecha/3", "ninguna", ...)
+    for (int tipo = XOR_CON_IM; tipo <= NINGUNA; tipo++) {
+        for (int bits = 0; bits < 8; bits++) {
+            Transformacion candidata = {(TipoTransformacion)tipo, bits};
+            if ((tipo == NINGUNA || tipo == XOR_CON_IM) && bits != 0) continue;
+            if (nombreTransformacion(candidata) == nombre) {
+                trans = candidata;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool leerResultadoCache(const QString& dirCache, const QString& clave, vector<Transformacion>& secuencia, bool& completa) {
+    // Formato: "resultado 1", "completa 0|1" y una transformación por línea, del primer paso al último
+    ifstream entrada((dirCache + "/" + clave + ".resultado").toStdString());
+    string linea;
+    if (!getline(entrada, linea) || linea != "resultado 1") return false;
+    if (!getline(entrada, linea) || linea.rfind("completa ", 0) != 0) return false;
+    completa = linea == "completa 1";
+
+    secuencia.clear();
+    while (getline(entrada, linea)) {
+        Transformacion trans;
+        if (!leerNombreTransformacion(linea, trans)) return false;
+        secuencia.push_back(trans);
+    }
+    return !secuencia.empty();
+}
+
+static void recortarCache(const QString& dirCache, const QString& claveActual, long long limiteBytes) {
+    // Mientras la caché supere el límite se borran las entradas usadas hace más tiempo (cada
+    // uso reescribe el .resultado, así que su fecha es la del último uso). La actual no se toca.
+    QDir dir(dirCache);
+    QStringList resultados = dir.entryList(QStringList() << "*.resultado", QDir::Files);
+    vector<pair<long long, QString>> entradas;  // (fecha, clave)
+    long long total = 0;
+    for (const QString& nombre : resultados) {
+        QString clave = QFileInfo(nombre).completeBaseName();
+        QFileInfo info(dirCache + "/" + nombre);
+        QFileInfo imagen(dirCache + "/" + clave + ".bmp");
+        total += info.size() + (imagen.exists() ? imagen.size() : 0);
+        if (clave != claveActual) entradas.push_back(make_pair(info.lastModified().toMSecsSinceEpoch(), clave));
+    }
+    sort(entradas.begin(), entradas.end());
+    for (size_t i = 0; i < entradas.size() && total > limiteBytes; i++) {
+        QString base = dirCache + "/" + entradas[i].second;
+        total -= QFileInfo(base + ".resultado").size() + QFileInfo(base + ".bmp").size();
+        QFile::remove(base + ".resultado");
+        QFile::remove(base + ".bmp");
+    }
+}
+
+void guardarResultadoCache(const QString& dirCache, const QString& clave, const vector<Transformacion>& secuencia,
+                           bool completa, const QString& imagenReconstruida, long long limiteBytes) {
+    // Se escribe en un temporal y se renombra, para que otro hilo o proceso nunca lea una
+    // entrada a medias
+    static mutex mtxCache;
+    lock_guard<mutex> lock(mtxCache);
+    QDir().mkpath(dirCache);
+    QString base = dirCache + "/" + clave;
+
+    // Los temporales llevan el pid: el mutex solo ordena los hilos de este proceso. Cada entrada
+    // se reemplaza con un único rename; si falla, otro proceso la dejó y se descarta la propia.
+    QString pid = QString::number(QCoreApplication::applicationPid());
+    if (!imagenReconstruida.isEmpty() && !QFile::exists(base + ".bmp")) {
+        QString temporalImagen = base + ".bmp.tmp" + pid;
+        QFile::remove(temporalImagen);  // Restos de un proceso anterior con el mismo pid
+        if (!QFile::copy(imagenReconstruida, temporalImagen) || !reemplazarArchivo(temporalImagen, base + ".bmp")) {
+            QFile::remove(temporalImagen);
+        }
+    }
+
+    string texto = string("resultado 1\ncompleta ") + (completa ? "1" : "0") + "\n";
+    for (const Transformacion& trans : secuencia) texto += nombreTransformacion(trans) + "\n";
+    QString temporal = base + ".resultado.tmp" + pid;
+    QFile archivo(temporal);
+    if (!archivo.open(QIODevice::WriteOnly) || archivo.write(texto.data(), texto.size()) != (long long)texto.size()) {
+        QFile::remove(temporal);
+        return;
+    }
+    archivo.close();
+    if (!reemplazarArchivo(temporal, base + ".resultado")) QFile::remove(temporal);
+
+    recortarCache(dirCache, clave, limiteBytes);
+}
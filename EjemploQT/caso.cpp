@@ -0,0 +1,509 @@
+// Un caso completo: carga sus archivos, busca la secuencia con la biblioteca, vuelca los
+// diagnósticos y guarda la imagen reconstruida (en memoria o por bloques)
+
+#include <QDir>
+#include <QFileInfo>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+#include "aplicacion.h"
+
+using namespace std;
+
+bool resolverCaso(const QString& casoDirectorio, const QString& dirSalida,
+const OpcionesEjecucion& opciones, EscritorAsincrono& escritor, EstadisticasCaso* estadisticas,
+const function<void(const VolcadosCaso&)>& alTerminarVolcados);
+
+bool reconstruirImagen(const QString& casoDirectorio, const QString& dirSalida,
+                       const OpcionesEjecucion& opciones, EscritorAsincrono& escritor, EstadisticasCaso* estadisticas,
+                       const function<void(const VolcadosCaso&)>& alTerminarVolcados)
+{
+    // Sin --perfil ni --traza no hay perfilador activo y las mediciones no hacen nada
+    if (!opciones.perfil && opciones.traza.isEmpty()) {
+        return resolverCaso(casoDirectorio, dirSalida, opciones, escritor, estadisticas, alTerminarVolcados);
+    }
+
+    EstadisticasCaso estadisticasLocales;
+    if (!estadisticas) estadisticas = &estadisticasLocales;
+    Perfilador perfilador;
+    perfiladorActual = &perfilador;
+    bool exito;
+    {
+        TemporizadorFase fase("caso");
+        exito = resolverCaso(casoDirectorio, dirSalida, opciones, escritor, estadisticas, alTerminarVolcados);
+    }
+    perfiladorActual = nullptr;
+
+    QString nombreCaso = QFileInfo(casoDirectorio).fileName();
+    if (opciones.perfil) {
+        QDir().mkpath(dirSalida);
+        if (!guardarResumenPerfil(perfilador, dirSalida + "/perfil.json", nombreCaso, exito, *estadisticas)) {
+            registro() << "Error al guardar " << (dirSalida + "/perfil.json").toStdString() << endl;
+        }
+    }
+    if (!opciones.traza.isEmpty()) {
+        trazaGlobal.agregar(nombreCaso, perfilador);
+    }
+    return exito;
+}
+
+bool resolverCaso(const QString& casoDirectorio, const QString& dirSalida,
+                  const OpcionesEjecucion& opciones, EscritorAsincrono& escritor, EstadisticasCaso* estadisticas,
+                  const function<void(const VolcadosCaso&)>& alTerminarVolcados)
+{
+    NivelDiagnostico diagnostico = opciones.diagnostico;
+    QDir().mkpath(dirSalida);
+
+    // Encontrar archivos de entrada
+    QString archivoOriginal, archivoTransformado, archivoAleatoria, archivoMascara;
+    QStringList mascaras;
+
+    QDir dir(casoDirectorio);
+    QStringList archivos = dir.entryList(QStringList() << "*.bmp" << "*.BMP", QDir::Files);
+
+    for (const QString& archivo : archivos) {
+        QString rutaCompleta = dir.absolutePath() + "/" + archivo;
+        if (archivo.contains("_D", Qt::CaseInsensitive)) {
+            archivoOriginal = rutaCompleta;
+        } else if (archivo.contains("_O", Qt::CaseInsensitive)) {
+            // I_D (imagen distorsionada) tiene prioridad sobre I_O cuando ambas existen
+            if (archivoOriginal.isEmpty()) archivoOriginal = rutaCompleta;
+        } else if (archivo.contains("_M", Qt::CaseInsensitive)) {
+            archivoAleatoria = rutaCompleta;
+        } else if (archivo.startsWith("M.", Qt::CaseInsensitive)) {
+            archivoMascara = rutaCompleta;
+        }
+    }
+
+    // Encontrar archivos de máscara. El número del archivo es el paso que restringe: Mk.txt
+    // corresponde a la imagen antes de la transformación k+1 (M0 es la imagen original).
+    QStringList archivosMascara = dir.entryList(QStringList() << "M*.txt" << "m*.txt", QDir::Files);
+    for (const QString& mascara : archivosMascara) {
+        bool esNumero = false;
+        QFileInfo(mascara).baseName().mid(1).toInt(&esNumero);
+        if (esNumero) mascaras.append(dir.absolutePath() + "/" + mascara);
+    }
+
+    if (archivoOriginal.isEmpty() || archivoAleatoria.isEmpty() || archivoMascara.isEmpty() || mascaras.isEmpty()) {
+        registro() << "Error: No se encontraron los archivos necesarios" << endl;
+        return false;
+    }
+
+    // Ordenar mascaras por número (M1.txt, M2.txt, etc.)
+    std::sort(mascaras.begin(), mascaras.end(), [](const QString& a, const QString& b) {
+        QFileInfo infoA(a);
+        QFileInfo infoB(b);
+        QString numA = infoA.baseName().mid(1); // Quitar la M
+        QString numB = infoB.baseName().mid(1);
+        return numA.toInt() < numB.toInt();
+    });
+
+    registro() << "Archivos encontrados:" << endl;
+    registro() << "Original: " << archivoOriginal.toStdString() << endl;
+    registro() << "Aleatoria: " << archivoAleatoria.toStdString() << endl;
+    registro() << "Máscara: " << archivoMascara.toStdString() << endl;
+    registro() << "Mascaras (" << mascaras.size() << "):" << endl;
+    for (const QString& m : mascaras) {
+        registro() << "  - " << m.toStdString() << endl;
+    }
+
+    // La caché de resultados se consulta por el contenido de todos los archivos del caso
+    QString claveCache;
+    vector<Transformacion> secuenciaCache;
+    bool completaCache = false, enCache = false;
+    if (!opciones.cacheResultados.isEmpty()) {
+        TemporizadorFase fase("cache_resultados");
+        claveCache = claveCaso(QStringList() << archivoOriginal << archivoAleatoria << archivoMascara << mascaras);
+        enCache = !claveCache.isEmpty() &&
+                  leerResultadoCache(opciones.cacheResultados, claveCache, secuenciaCache, completaCache);
+        registro() << (enCache ? "Resultado en caché: " : "Sin resultado en caché: ") << claveCache.toStdString() << endl;
+
+        // Con la imagen reconstruida en la caché, sin volcados ni verificación, no hace falta
+        // ni cargar las imágenes
+        QString imagenCache = opciones.cacheResultados + "/" + claveCache + ".bmp";
+        QString archivoReconstruida = dirSalida + "/imagen_reconstruida.bmp";
+        if (enCache && diagnostico == DIAGNOSTICO_NINGUNO && !opciones.cacheVerificar && QFile::exists(imagenCache)) {
+            QFile::remove(archivoReconstruida);
+            if (QFile::copy(imagenCache, archivoReconstruida)) {
+                guardarResultadoCache(opciones.cacheResultados, claveCache, secuenciaCache, completaCache, QString(),
+                                      (long long)opciones.cacheMaxMB * 1024 * 1024);
+                if (estadisticas) {
+                    estadisticas->pasos = (int)secuenciaCache.size();
+                    estadisticas->secuenciaCompleta = completaCache;
+                    estadisticas->secuencia = secuenciaCache;
+                }
+                registro() << "\nImagen reconstruida copiada de la caché en: " << archivoReconstruida.toStdString() << endl;
+                registrarSecuencia(secuenciaCache);
+                registro() << "\nProceso completado para este caso!" << endl;
+                return true;
+            }
+        }
+    }
+
+    // Cargar imágenes
+    int ancho = 0, alto = 0;
+    int ancho2 = 0, alto2 = 0;
+
+    // Todos los buffers del caso salen del pool del hilo y vuelven a él al terminar, así que
+    // el siguiente caso del mismo tamaño no reserva memoria nueva
+    PoolBuffers& pool = poolDelHilo();
+
+    // En el modo por bloques solo se leen las cabeceras: las imágenes se recorren después por
+    // bloques de filas y nunca están completas en memoria
+    bool porBloques = opciones.porBloques;
+    LectorBmpPorBloques lectorFinal, lectorAuxiliar;
+    if (porBloques && !(lectorFinal.abrir(archivoOriginal) && lectorAuxiliar.abrir(archivoAleatoria))) {
+        registro() << "Aviso: el modo por bloques solo admite BMP de 24 bits sin compresión, "
+                   << "se cargan las imágenes completas" << endl;
+        porBloques = false;
+    }
+
+    registro() << "\nCargando imágenes..." << endl;
+    TemporizadorFase faseCarga("cargar_imagenes");
+    BufferPrestado original(pool, porBloques ? nullptr : cargarImagen(archivoOriginal, ancho, alto, &pool));
+    BufferPrestado aleatoria(pool, porBloques ? nullptr : cargarImagen(archivoAleatoria, ancho2, alto2, &pool));
+    if (porBloques) {
+        ancho = lectorFinal.cabecera().ancho;
+        alto = lectorFinal.cabecera().alto;
+        ancho2 = lectorAuxiliar.cabecera().ancho;
+        alto2 = lectorAuxiliar.cabecera().alto;
+    }
+
+    if((!porBloques && (!original || !aleatoria)) || ancho != ancho2 || alto != alto2) {
+        registro() << "Error: Las imágenes no coinciden en dimensiones o no se pudieron cargar" << endl;
+        return false;
+    }
+
+    // La máscara M es la imagen que se sumó a la ventana de cada paso para producir los Mk.txt
+    int anchoMascara = 0, altoMascara = 0;
+    BufferPrestado mascara(pool, cargarImagen(archivoMascara, anchoMascara, altoMascara, &pool));
+    if(!mascara) {
+        registro() << "Error: No se pudo cargar la máscara " << archivoMascara.toStdString() << endl;
+        return false;
+    }
+    long long bytesMascara = (long long)anchoMascara * altoMascara * 3;
+    faseCarga.terminar();
+
+    long long totalPixeles = (long long)ancho * alto * 3;
+
+    // La idea es reconstruir la secuencia de transformaciones aplicadas
+    // Sabemos que después de cada transformación (excepto la última) se aplicó un enmascaramiento
+    // Y tenemos los archivos M1.txt, M2.txt, etc.
+
+    registro() << "\nAnalizando posibles transformaciones..." << endl;
+
+    // Hay tantos pasos como indica la máscara de mayor número: con M0..M6 son 7 transformaciones
+    int numPasos = QFileInfo(mascaras.last()).baseName().mid(1).toInt() + 1;
+    vector<DatosMascara> datosPasos(numPasos);
+
+    // El caso para la biblioteca de reconstrucción: solo apunta a los buffers ya cargados
+    CasoEnMemoria caso;
+    caso.imagenFinal = original;
+    caso.imagenAuxiliar = aleatoria;
+    caso.totalPixeles = totalPixeles;
+    caso.mascara = mascara;
+    caso.bytesMascara = bytesMascara;
+    caso.restricciones.assign(numPasos, nullptr);
+
+    for (const QString& archivoPaso : mascaras) {
+        int i = QFileInfo(archivoPaso).baseName().mid(1).toInt();
+        registro() << "Procesando paso " << i+1 << " usando mascara: " << archivoPaso.toStdString() << endl;
+
+        // Cargar datos de enmascaramiento
+        DatosMascara& datos = datosPasos[i];
+        TemporizadorFase faseMascara("cargar_mascara");
+        if(!cargarDatosEnmascaramiento(archivoPaso, datos, opciones.cacheMascaras)) {
+            registro() << "Error al cargar el archivo de enmascaramiento: " << archivoPaso.toStdString() << endl;
+            continue;
+        }
+        registro() << "  Datos de enmascaramiento cargados. Semilla: " << datos.semilla << ", Píxeles: " << datos.cantidad << endl;
+
+        // Cada Mk.txt solo restringe los bytes de la ventana que empieza en la semilla: ahí
+        // conocemos el valor exacto de la imagen antes de la transformación (suma - máscara).
+        caso.restricciones[i] = &datos;
+    }
+
+    // No se guardan las imágenes intermedias: la búsqueda trabaja sobre estados compuestos
+    // (dos tablas de 256 entradas) y solo hace falta un buffer de trabajo para los volcados
+    // y la reconstrucción final. Cualquier paso se vuelve a obtener con materializarPaso.
+    // Modo por bloques: una pasada por las imágenes saca la ventana de cada paso y el
+    // histograma conjunto, que es todo lo que necesita la búsqueda
+    vector<uint64_t> histograma;
+    vector<vector<unsigned char>> ventanasFinal(numPasos), ventanasAuxiliar(numPasos);
+    if (porBloques) {
+        TemporizadorFase fase("analisis_por_bloques");
+        histograma.assign(256 * 256, 0);
+        for (int i = 0; i < numPasos; i++) {
+            ventanasFinal[i].resize(bytesVentanaPaso(caso, i));
+            ventanasAuxiliar[i].resize(bytesVentanaPaso(caso, i));
+        }
+        if (!analizarPorBloques(lectorFinal, lectorAuxiliar, caso, ventanasFinal, ventanasAuxiliar, histograma.data())) {
+            registro() << "Error: no se pudieron leer las imágenes por bloques" << endl;
+            return false;
+        }
+        caso.histograma = histograma.data();
+        caso.imagenFinal = nullptr;
+        caso.imagenAuxiliar = nullptr;
+        for (int i = 0; i < numPasos; i++) {
+            caso.ventanasFinal.push_back(ventanasFinal[i].data());
+            caso.ventanasAuxiliar.push_back(ventanasAuxiliar[i].data());
+        }
+    }
+
+    BufferPrestado trabajo(pool, porBloques ? nullptr : pool.adquirir(totalPixeles));
+
+    // Hilos dentro del caso (la biblioteca decide si el caso es lo bastante grande para usarlos)
+    caso.hilos = max(1, opciones.hilosCaso);
+
+    // Los volcados de este caso: los que no se pudieron escribir se informan cuando el escritor
+    // termina con ellos, sin que el caso lo espere
+    shared_ptr<VolcadosCaso> volcados = make_shared<VolcadosCaso>();
+
+    if (diagnostico == DIAGNOSTICO_TODOS && porBloques) {
+        registro() << "  Aviso: en el modo por bloques no se vuelcan los candidatos probados" << endl;
+    } else if (diagnostico == DIAGNOSTICO_TODOS) {
+        caso.alProbar = [&](int paso, Transformacion trans, const EstadoParcial& estado) {
+            // La imagen completa del candidato solo se calcula si se va a volcar
+            TemporizadorFase fase("volcado_diagnostico");
+            contarPerfil(CONTADOR_IMAGENES_VOLCADAS);
+            aplicarCompuesta(estadoAnterior(estado, trans).desdeFinal, original, aleatoria, trabajo, totalPixeles);
+            QString nombrePaso = dirSalida + "/prueba_paso" + QString::number(paso) +
+                                "_tipo" + QString::number(trans.tipo) + "_bits" + QString::number(trans.bits) + ".bmp";
+            escritor.encolar(trabajo, ancho, alto, nombrePaso, volcados, true);
+        };
+    }
+
+    // Lo que sale de la caché solo se usa si corresponde a la misma cantidad de pasos y, con
+    // --cache-verificar, si cumple las máscaras como lo haría un resultado de la búsqueda
+    if (enCache && (int)secuenciaCache.size() != numPasos) {
+        enCache = false;
+    } else if (enCache && opciones.cacheVerificar) {
+        TemporizadorFase fase("cache_verificacion");
+        if (!verificarSecuencia(caso, secuenciaCache)) {
+            registro() << "  La secuencia de la caché no cumple las máscaras, se vuelve a buscar" << endl;
+            enCache = false;
+        }
+    }
+
+    ResultadoSecuencia resultado;
+    double msBusqueda = 0;
+    if (enCache) {
+        registro() << "  Secuencia tomada de la caché, sin búsqueda" << endl;
+        resultado.completa = completaCache;
+        resultado.secuencia = secuenciaCache;
+    } else {
+        auto inicioBusqueda = chrono::steady_clock::now();
+        TemporizadorFase faseBusqueda("busqueda");
+        detectarSecuencia(caso, resultado);
+        faseBusqueda.terminar();
+        msBusqueda = chrono::duration<double, milli>(chrono::steady_clock::now() - inicioBusqueda).count();
+
+        registro() << "  Búsqueda: " << resultado.estados << " estados, " << resultado.candidatosVerificados
+                   << " candidatos verificados, " << resultado.candidatosDescartados
+                   << " descartados por el clasificador, " << resultado.podasMemo << " estados repetidos, "
+                   << msBusqueda << " ms" << endl;
+    }
+    bool secuenciaCompleta = resultado.completa;
+
+    if (estadisticas) {
+        estadisticas->ancho = ancho;
+        estadisticas->alto = alto;
+        estadisticas->pasos = numPasos;
+        estadisticas->secuenciaCompleta = secuenciaCompleta;
+        estadisticas->estados = resultado.estados;
+        estadisticas->candidatosVerificados = resultado.candidatosVerificados;
+        estadisticas->candidatosDescartados = resultado.candidatosDescartados;
+        estadisticas->msBusqueda = msBusqueda;
+    }
+
+    // Si ninguna secuencia cumple todas las máscaras la biblioteca devuelve el sufijo más largo
+    // que sí las cumple; los pasos anteriores (y los que no tienen Mk.txt) quedan sin identificar
+    vector<Transformacion> secuenciaTransformaciones = resultado.secuencia;
+    if (!secuenciaCompleta) {
+        registro() << "  No se identificó una secuencia completa que cumpla todas las máscaras" << endl;
+    }
+    if (estadisticas) estadisticas->secuencia = secuenciaTransformaciones;
+
+    vector<pair<TransformacionCompuesta, QString>> salidasPorBloques;
+    for (int i = numPasos - 1; i >= 0; i--) {
+        Transformacion trans = secuenciaTransformaciones[i];
+        if (trans.tipo == NINGUNA) {
+            registro() << "  No se pudo determinar la transformación para el paso " << i+1 << endl;
+            continue;
+        }
+
+        registro() << "  Transformación encontrada para paso " << i+1 << ": ";
+        switch(trans.tipo) {
+            case XOR_CON_IM: registro() << "XOR con imagen aleatoria"; break;
+            case ROTACION_DERECHA: registro() << "Rotación derecha " << trans.bits << " bits"; break;
+            case ROTACION_IZQUIERDA: registro() << "Rotación izquierda " << trans.bits << " bits"; break;
+            case DESPLAZAMIENTO_DERECHA: registro() << "Desplazamiento derecha " << trans.bits << " bits"; break;
+            case DESPLAZAMIENTO_IZQUIERDA: registro() << "Desplazamiento izquierda " << trans.bits << " bits"; break;
+            default: registro() << "Desconocida"; break;
+        }
+        registro() << endl;
+
+        // Guardar la imagen reconstruida de este paso (en el modo por bloques se escriben todas
+        // juntas en la misma pasada que la imagen final)
+        if (diagnostico >= DIAGNOSTICO_ACEPTADOS && porBloques) {
+            vector<Transformacion> resto(secuenciaTransformaciones.begin() + i, secuenciaTransformaciones.end());
+            salidasPorBloques.push_back(make_pair(componerSecuencia(resto, true),
+                                                  dirSalida + "/paso_" + QString::number(i) + "_reconstruido.bmp"));
+        } else if (diagnostico >= DIAGNOSTICO_ACEPTADOS) {
+            TemporizadorFase fase("volcado_diagnostico");
+            contarPerfil(CONTADOR_IMAGENES_VOLCADAS);
+            materializarPaso(secuenciaTransformaciones, i, original, aleatoria, trabajo, totalPixeles);
+            QString nombrePaso = dirSalida + "/paso_" + QString::number(i) + "_reconstruido.bmp";
+            escritor.encolar(trabajo, ancho, alto, nombrePaso, volcados);
+        }
+    }
+
+    // Reconstrucción final de la imagen original: toda la secuencia inversa compuesta en una
+    // sola pasada sobre la imagen transformada (el buffer de trabajo ya no se necesita)
+    QString archivoReconstruida = dirSalida + "/imagen_reconstruida.bmp";
+    bool guardada = true;
+    if (porBloques) {
+        TemporizadorFase fase("reconstruccion_por_bloques");
+        salidasPorBloques.push_back(make_pair(componerSecuencia(secuenciaTransformaciones, true), archivoReconstruida));
+        if (!reconstruirPorBloques(lectorFinal, lectorAuxiliar, salidasPorBloques)) {
+            registro() << "Error al reconstruir por bloques: " << archivoReconstruida.toStdString() << endl;
+            return false;
+        }
+    } else {
+        unsigned char* imagenReconstruida = trabajo;
+        {
+            TemporizadorFase fase("reconstruccion_final");
+            materializarPaso(secuenciaTransformaciones, 0, original, aleatoria, imagenReconstruida, totalPixeles);
+        }
+
+        // Guardar imagen reconstruida
+        TemporizadorFase fase("guardar_imagen");
+        guardada = guardarImagen(imagenReconstruida, ancho, alto, archivoReconstruida);
+    }
+
+    // Los volcados no hacen fallar el caso. Los descartados ya se saben; los errores de escritura
+    // van a alTerminarVolcados o, sin él, a cerr (el registro del caso puede estar ya impreso)
+    if (volcados->descartados > 0) {
+        registro() << "Aviso: se descartaron " << volcados->descartados << " imágenes de candidatos probados" << endl;
+    }
+    if (estadisticas) estadisticas->volcadosDescartados = volcados->descartados;
+    escritor.cerrar(volcados, alTerminarVolcados ? alTerminarVolcados : [](const VolcadosCaso& terminados) {
+        for (const string& error : terminados.errores) cerr << error;
+        cerr << flush;
+    });
+    if (!guardada) return false;  // Sin la imagen reconstruida el caso no está resuelto
+    registro() << "\nImagen reconstruida guardada en: " << archivoReconstruida.toStdString() << endl;
+
+    registrarSecuencia(secuenciaTransformaciones);
+
+    // Guardar el resultado (o renovar su fecha si vino de la caché, para el descarte por antigüedad)
+    if (!claveCache.isEmpty()) {
+        guardarResultadoCache(opciones.cacheResultados, claveCache, secuenciaTransformaciones, secuenciaCompleta,
+                              opciones.cacheImagenes ? archivoReconstruida : QString(),
+                              (long long)opciones.cacheMaxMB * 1024 * 1024);
+    }
+
+    registro() << "\nProceso completado para este caso!" << endl;
+    return true;
+}
+
+void registrarSecuencia(const vector<Transformacion>& secuencia)
+{
+    // Mostrar la secuencia de transformaciones encontrada
+    registro() << "\nSecuencia de transformaciones detectada (del primer al último paso):" << endl;
+    for (size_t i = 0; i < secuencia.size(); i++) {
+        Transformacion t = secuencia[i];
+        registro() << "Paso " << i+1 << ": ";
+        switch(t.tipo) {
+            case XOR_CON_IM: registro() << "XOR con imagen aleatoria"; break;
+            case ROTACION_DERECHA: registro() << "Rotación derecha " << t.bits << " bits"; break;
+            case ROTACION_IZQUIERDA: registro() << "Rotación izquierda " << t.bits << " bits"; break;
+            case DESPLAZAMIENTO_DERECHA: registro() << "Desplazamiento derecha " << t.bits << " bits"; break;
+            case DESPLAZAMIENTO_IZQUIERDA: registro() << "Desplazamiento izquierda " << t.bits << " bits"; break;
+            case NINGUNA: registro() << "No identificada"; break;
+        }
+        registro() << endl;
+    }
+}
+
+// Bloques del modo por bloques: alrededor de 1 MB de filas, que entra en la caché L2/L3
+static const int TAMANO_BLOQUE_FILAS = 1 << 20;
+
+bool analizarPorBloques(LectorBmpPorBloques& lectorFinal, LectorBmpPorBloques& lectorAuxiliar, const CasoEnMemoria& caso,
+                        vector<vector<unsigned char>>& ventanasFinal, vector<vector<unsigned char>>& ventanasAuxiliar,
+                        uint64_t* histograma) {
+    // Una pasada por las dos imágenes: cuenta cada par (final, auxiliar) y copia los bytes que
+    // caen en la ventana de algún paso. La ventana empieza en la semilla y puede dar la vuelta.
+    int ancho = lectorFinal.cabecera().ancho;
+    int filasPorBloque = max(1, TAMANO_BLOQUE_FILAS / (ancho * 3));
+    lectorFinal.iniciar(filasPorBloque);
+    lectorAuxiliar.iniciar(filasPorBloque);
+    long long totalPixeles = caso.totalPixeles;
+
+    int primeraFila = 0, filas = 0, primeraAux = 0, filasAux = 0;
+    const unsigned char* bloqueFinal;
+    const unsigned char* bloqueAuxiliar;
+    while ((bloqueFinal = lectorFinal.siguiente(primeraFila, filas)) &&
+           (bloqueAuxiliar = lectorAuxiliar.siguiente(primeraAux, filasAux))) {
+        long long inicioBloque = (long long)primeraFila * ancho * 3;
+        long long bytesBloque = (long long)filas * ancho * 3;
+        for (long long i = 0; i < bytesBloque; i++) {
+            histograma[bloqueFinal[i] * 256 + bloqueAuxiliar[i]]++;
+        }
+        contarPerfil(CONTADOR_BYTES_RECORRIDOS, bytesBloque);
+
+        for (size_t paso = 0; paso < caso.restricciones.size(); paso++) {
+            long long longitud = ventanasFinal[paso].size();
+            if (!caso.restricciones[paso] || longitud == 0) continue;
+            long long inicio = caso.restricciones[paso]->semilla % totalPixeles;
+            // Tramos contiguos de la ventana: [inicio, fin de la imagen), [0, ...), ...
+            for (long long j = 0; j < longitud; ) {
+                long long posicion = (inicio + j) % totalPixeles;
+                long long largo = min(longitud - j, totalPixeles - posicion);
+                long long desde = max(posicion, inicioBloque);
+                long long hasta = min(posicion + largo, inicioBloque + bytesBloque);
+                if (desde < hasta) {
+                    memcpy(ventanasFinal[paso].data() + j + (desde - posicion),
+                           bloqueFinal + (desde - inicioBloque), hasta - desde);
+                    memcpy(ventanasAuxiliar[paso].data() + j + (desde - posicion),
+                           bloqueAuxiliar + (desde - inicioBloque), hasta - desde);
+                }
+                j += largo;
+            }
+        }
+    }
+    return !lectorFinal.fallo() && !lectorAuxiliar.fallo();
+}
+
+bool reconstruirPorBloques(LectorBmpPorBloques& lectorFinal, LectorBmpPorBloques& lectorAuxiliar,
+                           const vector<pair<TransformacionCompuesta, QString>>& salidas) {
+    // Cada salida es la imagen final con una transformación compuesta aplicada; todas se
+    // escriben en la misma pasada por las imágenes de entrada
+    int ancho = lectorFinal.cabecera().ancho;
+    int alto = lectorFinal.cabecera().alto;
+    int filasPorBloque = max(1, TAMANO_BLOQUE_FILAS / (ancho * 3));
+
+    vector<unique_ptr<EscritorBmpPorBloques>> escritores;
+    for (const auto& salida : salidas) {
+        escritores.emplace_back(new EscritorBmpPorBloques());
+        if (!escritores.back()->abrir(salida.second, ancho, alto)) return false;
+    }
+
+    lectorFinal.iniciar(filasPorBloque);
+    lectorAuxiliar.iniciar(filasPorBloque);
+    vector<unsigned char> resultado((size_t)filasPorBloque * ancho * 3);
+    int primeraFila = 0, filas = 0, primeraAux = 0, filasAux = 0;
+    const unsigned char* bloqueFinal;
+    const unsigned char* bloqueAuxiliar;
+    while ((bloqueFinal = lectorFinal.siguiente(primeraFila, filas)) &&
+           (bloqueAuxiliar = lectorAuxiliar.siguiente(primeraAux, filasAux))) {
+        long long bytesBloque = (long long)filas * ancho * 3;
+        for (size_t i = 0; i < salidas.size(); i++) {
+            aplicarCompuesta(salidas[i].first, bloqueFinal, bloqueAuxiliar, resultado.data(), bytesBloque);
+            if (!escritores[i]->escribir(resultado.data(), primeraFila, filas)) return false;
+        }
+    }
+    return !lectorFinal.fallo() && !lectorAuxiliar.fallo();
+}
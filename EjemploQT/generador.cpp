@@ -0,0 +1,173 @@
+// Generador de casos (--generar)
+
+#include <QDir>
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <random>
+
+#include "aplicacion.h"
+
+using namespace std;
+
+static void rellenarAleatorio(unsigned char* datos, int n, unsigned int semilla, int tramo, int flujo) {
+    // Cada tramo tiene su propio generador, así el resultado no depende de cuántos hilos haya
+    seed_seq secuenciaSemilla{semilla, (unsigned int)tramo, (unsigned int)flujo};
+    mt19937_64 generador(secuenciaSemilla);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        uint64_t v = generador();
+        memcpy(datos + i, &v, 8);
+    }
+    uint64_t v = generador();
+    for (; i < n; i++, v >>= 8) datos[i] = v & 0xFF;
+}
+
+bool generarCaso(const ParametrosGenerador& parametros) {
+    // Codificador directo: genera un caso con el mismo formato que los del enunciado. Se
+    // escriben I_O.bmp (la imagen de partida, como referencia), I_M.bmp, M.bmp, un Mk.txt por
+    // paso (semilla y sumas de la ventana de la imagen antes del paso k+1 con la máscara),
+    // I_D.bmp con el resultado y secuencia.txt con los pasos aplicados.
+    //
+    // Todas las transformaciones son por byte, así que la imagen se divide en tramos de 1 MB
+    // y cada hilo aplica la secuencia completa a su tramo mientras está en caché; las sumas
+    // de cada ventana las anota el tramo que contiene cada byte. Solo hay dos imágenes en
+    // memoria (estado e I_M) sin importar la cantidad de pasos.
+    auto inicio = chrono::steady_clock::now();
+    QString dirCaso = parametros.dirCaso;
+    QDir().mkpath(dirCaso);
+    mt19937_64 generador(parametros.semilla);
+
+    int ancho = parametros.ancho, alto = parametros.alto;
+    unique_ptr<unsigned char[]> estado;
+    if (!parametros.imagenOrigen.isEmpty()) {
+        estado.reset(cargarImagen(parametros.imagenOrigen, ancho, alto));
+        if (!estado) {
+            registro() << "Error: no se pudo cargar la imagen de origen " << parametros.imagenOrigen.toStdString() << endl;
+            return false;
+        }
+    }
+    long long totalPixeles = (long long)ancho * alto * 3;
+
+    int anchoMascara = 10, altoMascara = 10;
+    unique_ptr<unsigned char[]> mascara;
+    if (!parametros.imagenMascara.isEmpty()) {
+        mascara.reset(cargarImagen(parametros.imagenMascara, anchoMascara, altoMascara));
+        if (!mascara) {
+            registro() << "Error: no se pudo cargar la máscara " << parametros.imagenMascara.toStdString() << endl;
+            return false;
+        }
+    } else {
+        mascara.reset(new unsigned char[anchoMascara * altoMascara * 3]);
+        for (int j = 0; j < anchoMascara * altoMascara * 3; j++) mascara[j] = generador() & 0xFF;
+    }
+    int bytesMascara = anchoMascara * altoMascara * 3;
+    if (bytesMascara > totalPixeles) {
+        registro() << "Error: la máscara es más grande que la imagen" << endl;
+        return false;
+    }
+
+    // Secuencia y semillas de las ventanas: se deciden antes de repartir el trabajo
+    vector<Transformacion> secuencia = parametros.secuencia;
+    if (secuencia.empty()) {
+        // Primero el tipo y después la cantidad de bits, para que el XOR no quede relegado
+        TipoTransformacion tipos[] = {XOR_CON_IM, ROTACION_DERECHA, ROTACION_IZQUIERDA,
+                                      DESPLAZAMIENTO_DERECHA, DESPLAZAMIENTO_IZQUIERDA};
+        for (int k = 0; k < parametros.pasos; k++) {
+            TipoTransformacion tipo = tipos[generador() % 5];
+            secuencia.push_back({tipo, tipo == XOR_CON_IM ? 0 : 1 + (int)(generador() % 7)});
+        }
+    }
+    int numPasos = secuencia.size();
+    // Uniformes en toda la imagen, también más allá de 2^32 bytes
+    uniform_int_distribution<long long> posicionVentana(0, totalPixeles - 1);
+    vector<long long> semillas(numPasos);
+    for (int k = 0; k < numPasos; k++) semillas[k] = posicionVentana(generador);
+    vector<vector<uint16_t>> sumas(numPasos, vector<uint16_t>(bytesMascara));
+
+    int numHilos = parametros.hilos > 0 ? parametros.hilos : (int)thread::hardware_concurrency();
+    const int tamTramo = 1 << 20;
+    int numTramos = (int)((totalPixeles + tamTramo - 1) / tamTramo);
+    numHilos = max(1, min(numHilos, numTramos));
+    registro() << "Generando caso en " << dirCaso.toStdString() << ": " << ancho << "x" << alto << ", "
+         << numPasos << " pasos, " << numHilos << " hilos" << endl;
+
+    unique_ptr<unsigned char[]> aleatoria(new unsigned char[totalPixeles]);
+    bool origenAleatorio = !estado;
+    if (origenAleatorio) estado.reset(new unsigned char[totalPixeles]);
+    unsigned char* pEstado = estado.get();
+    unsigned char* pAleatoria = aleatoria.get();
+    PoolHilos pool(numHilos);
+
+    // Fase 1: imágenes aleatorias, por tramos
+    for (int t = 0; t < numTramos; t++) {
+        pool.encolar([&, t]() {
+            long long desde = (long long)t * tamTramo;
+            int n = (int)min<long long>(tamTramo, totalPixeles - desde);
+            if (origenAleatorio) rellenarAleatorio(pEstado + desde, n, parametros.semilla, t, 0);
+            rellenarAleatorio(pAleatoria + desde, n, parametros.semilla, t, 1);
+        });
+    }
+    pool.esperar();
+    if (!guardarImagen(pEstado, ancho, alto, dirCaso + "/I_O.bmp") ||
+        !guardarImagen(pAleatoria, ancho, alto, dirCaso + "/I_M.bmp") ||
+        !guardarImagen(mascara.get(), anchoMascara, altoMascara, dirCaso + "/M.bmp")) {
+        registro() << "Error: no se pudieron escribir las imágenes en " << dirCaso.toStdString() << endl;
+        return false;
+    }
+
+    // Fase 2: cada tramo recorre toda la secuencia, anotando antes de cada paso las sumas de
+    // los bytes de la ventana que caen en él. Como en analizarPorBloques, la ventana se parte
+    // en tramos contiguos y solo se recorre su intersección con [desde, hasta).
+    for (int t = 0; t < numTramos; t++) {
+        pool.encolar([&, t]() {
+            long long desde = (long long)t * tamTramo, hasta = min(desde + tamTramo, totalPixeles);
+            for (int k = 0; k < numPasos; k++) {
+                for (long long j = 0; j < bytesMascara; ) {
+                    long long posicion = (semillas[k] + j) % totalPixeles;
+                    long long largo = min(bytesMascara - j, totalPixeles - posicion);
+                    long long primero = max(posicion, desde);
+                    long long ultimo = min(posicion + largo, hasta);
+                    for (long long p = primero; p < ultimo; p++) {
+                        long long indice = j + (p - posicion);
+                        sumas[k][indice] = pEstado[p] + mascara[indice];
+                    }
+                    j += largo;
+                }
+                aplicarTransformacion(pEstado + desde, pEstado + desde, hasta - desde, secuencia[k], pAleatoria + desde);
+            }
+        });
+    }
+    pool.esperar();
+
+    // Archivos de salida: un Mk.txt por paso, la secuencia aplicada e I_D.bmp
+    string textoSecuencia;
+    for (int k = 0; k < numPasos; k++) {
+        string texto = to_string(semillas[k]) + "\n";
+        char numero[8];
+        for (int j = 0; j < bytesMascara; j++) {
+            char* fin = to_chars(numero, numero + sizeof(numero), sumas[k][j]).ptr;
+            texto.append(numero, fin);
+            texto += (j % 3 == 2) ? '\n' : ' ';
+        }
+        QFile archivo(dirCaso + "/M" + QString::number(k) + ".txt");
+        if (!archivo.open(QIODevice::WriteOnly) || archivo.write(texto.data(), texto.size()) != (long long)texto.size()) {
+            registro() << "Error: no se pudo escribir " << archivo.fileName().toStdString() << endl;
+            return false;
+        }
+        textoSecuencia += nombreTransformacion(secuencia[k]) + "\n";
+    }
+    QFile archivoSecuencia(dirCaso + "/secuencia.txt");
+    if (archivoSecuencia.open(QIODevice::WriteOnly)) archivoSecuencia.write(textoSecuencia.data(), textoSecuencia.size());
+    archivoSecuencia.close();
+
+    if (!guardarImagen(pEstado, ancho, alto, dirCaso + "/I_D.bmp")) {
+        registro() << "Error: no se pudo escribir I_D.bmp en " << dirCaso.toStdString() << endl;
+        return false;
+    }
+
+    double segundos = chrono::duration<double>(chrono::steady_clock::now() - inicio).count();
+    registro() << "Caso generado en " << segundos << " s" << endl;
+    return true;
+}
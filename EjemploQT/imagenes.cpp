@@ -0,0 +1,161 @@
+// Carga y guardado de imágenes, y el escritor de imágenes en segundo plano
+
+#ifndef SIN_QTGUI
+#include <QImage>
+#endif
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+#include "aplicacion.h"
+
+using namespace std;
+
+unsigned char* cargarImagen(QString archivo, int &ancho, int &alto, PoolBuffers* pool) {
+    // Si se pasa un pool, el buffer sale de él y hay que devolverlo con pool->liberar()
+    unsigned char* pixeles = cargarBmpNativo(archivo, ancho, alto, pool);
+    if (pixeles) {
+        contarPerfil(CONTADOR_BYTES_ES, (long long)ancho * alto * 3);
+        return pixeles;
+    }
+
+#ifdef SIN_QTGUI
+    registro() << "Error al cargar (solo se admiten BMP de 24 bits sin QtGui): " << archivo.toStdString() << endl;
+    return nullptr;
+#else
+    // Otros formatos (paletas, compresión, PNG...) se siguen decodificando con QImage
+    QImage imagen(archivo);
+    if(imagen.isNull()) {
+        registro() << "Error al cargar: " << archivo.toStdString() << endl;
+        return nullptr;
+    }
+
+    imagen = imagen.convertToFormat(QImage::Format_RGB888);
+    ancho = imagen.width();
+    alto = imagen.height();
+
+    size_t tamano = (size_t)ancho * alto * 3;
+    pixeles = pool ? pool->adquirir(tamano) : new unsigned char[tamano];
+
+    for(int y = 0; y < alto; y++) {
+        memcpy(pixeles + (size_t)y * ancho * 3, imagen.scanLine(y), ancho * 3);
+    }
+    contarPerfil(CONTADOR_BYTES_ES, tamano);
+
+    return pixeles;
+#endif
+}
+
+bool guardarImagen(unsigned char* pixeles, int ancho, int alto, QString archivo) {
+    if(!guardarBmpNativo(pixeles, ancho, alto, archivo)) {
+        registro() << "Error al guardar: " << archivo.toStdString() << endl;
+        return false;
+    }
+    contarPerfil(CONTADOR_BYTES_ES, (long long)ancho * alto * 3);
+    return true;
+}
+
+EscritorAsincrono::EscritorAsincrono(size_t limiteBytes)
+    : limiteBytes(limiteBytes)
+{
+    hilo = thread([this]() { bucleEscritura(); });
+}
+
+EscritorAsincrono::~EscritorAsincrono()
+{
+    {
+        lock_guard<mutex> lock(mtx);
+        detener = true;
+    }
+    hayTrabajo.notify_all();
+    hilo.join();
+}
+
+bool EscritorAsincrono::encolar(const unsigned char* pixeles, int ancho, int alto, const QString& archivo,
+                                const shared_ptr<VolcadosCaso>& volcados, bool descartable)
+{
+    size_t tamano = (size_t)ancho * alto * 3;
+    {
+        unique_lock<mutex> lock(mtx);
+        if (descartable && bytesEnCola + tamano > limiteBytes) {
+            imagenesDescartadas++;
+            if (volcados) volcados->descartados++;
+            return false;
+        }
+        // Una imagen más grande que el límite entra igual cuando la cola está vacía
+        imagenEscrita.wait(lock, [&]() { return bytesEnCola == 0 || bytesEnCola + tamano <= limiteBytes; });
+        bytesEnCola += tamano;
+        enCurso++;
+        if (volcados) volcados->pendientes++;
+        cola.push(Pendiente{vector<unsigned char>(pixeles, pixeles + tamano), ancho, alto, archivo, volcados});
+    }
+    hayTrabajo.notify_one();
+    return true;
+}
+
+void EscritorAsincrono::cerrar(const shared_ptr<VolcadosCaso>& volcados, function<void(const VolcadosCaso&)> alTerminar)
+{
+    {
+        lock_guard<mutex> lock(mtx);
+        volcados->cerrado = true;
+        if (volcados->pendientes > 0) {
+            volcados->alTerminar = std::move(alTerminar);
+            return;
+        }
+    }
+    if (alTerminar) alTerminar(*volcados);
+}
+
+void EscritorAsincrono::esperar()
+{
+    unique_lock<mutex> lock(mtx);
+    imagenEscrita.wait(lock, [this]() { return enCurso == 0; });
+}
+
+void EscritorAsincrono::bucleEscritura()
+{
+    // Los mensajes de guardarImagen se juntan acá y se pasan al caso de cada imagen
+    ostringstream errores;
+    establecerRegistro(&errores);
+    while (true) {
+        Pendiente imagen;
+        {
+            unique_lock<mutex> lock(mtx);
+            hayTrabajo.wait(lock, [this]() { return detener || !cola.empty(); });
+            if (cola.empty()) return; // detener y sin pendientes
+            imagen = std::move(cola.front());
+            cola.pop();
+        }
+
+        errores.str("");
+        bool ok = guardarImagen(imagen.pixeles.data(), imagen.ancho, imagen.alto, imagen.archivo);
+        if (!ok) imagenesFallidas++;
+
+        // El aviso al caso se hace fuera del mutex: puede escribir en la salida del llamador
+        function<void(const VolcadosCaso&)> alTerminar;
+        {
+            lock_guard<mutex> lock(mtx);
+            bytesEnCola -= imagen.pixeles.size();
+            if (imagen.volcados) {
+                imagen.volcados->pendientes--;
+                if (!ok) {
+                    imagen.volcados->fallidos++;
+                    imagen.volcados->errores.push_back(errores.str());
+                }
+                if (imagen.volcados->cerrado && imagen.volcados->pendientes == 0) {
+                    alTerminar = std::move(imagen.volcados->alTerminar);
+                }
+            } else if (!ok) {
+                cerr << errores.str() << flush;
+            }
+        }
+        imagenEscrita.notify_all();  // Hay lugar en la cola
+        if (alTerminar) alTerminar(*imagen.volcados);
+
+        {
+            lock_guard<mutex> lock(mtx);
+            enCurso--;
+        }
+        imagenEscrita.notify_all();
+    }
+}
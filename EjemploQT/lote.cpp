@@ -0,0 +1,123 @@
+// Modo por defecto: resuelve todos los casos de ./casos, repartidos entre los hilos
+
+#include <QDir>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <sstream>
+
+#include "aplicacion.h"
+
+using namespace std;
+
+int ejecutarLote(OpcionesEjecucion opciones)
+{
+    // Directorios base (se pueden pasar como parámetros)
+    QString dirBase = QDir::currentPath();
+    QString dirSalida = dirBase + "/salida";
+
+    // Crear directorio de salida si no existe
+    QDir().mkpath(dirSalida);
+
+    EscritorAsincrono escritor((size_t)opciones.memoriaDiagnosticoMB * 1024 * 1024);
+
+    // Iterar sobre casos disponibles
+    QDir dirCasos(dirBase + "/casos");
+    QStringList casos = dirCasos.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+
+    // Un caso es exitoso si se reconstruyó con una secuencia que cumple todas sus máscaras; los
+    // que terminan con pasos sin identificar se cuentan aparte de los que fallaron
+    int totalCasos = max(1, (int)casos.size());
+    atomic<int> casosExitosos(0), casosIncompletos(0);
+    auto procesarCaso = [&](const QString& rutaCaso, const QString& dirSalidaCaso) {
+        EstadisticasCaso estadisticas;
+        if (!reconstruirImagen(rutaCaso, dirSalidaCaso, opciones, escritor, &estadisticas)) return;
+        if (estadisticas.secuenciaCompleta) casosExitosos++;
+        else casosIncompletos++;
+    };
+
+    if (casos.isEmpty()) {
+        cout << "No se encontraron casos para procesar en " << dirCasos.absolutePath().toStdString() << endl;
+        cout << "Por favor asegúrese de tener los directorios de casos correctamente ubicados." << endl;
+
+        // Fallback a un caso específico si no se encuentran casos
+        QString casoPath = dirBase + "/Desafio1_25/EjemploQT/caso1";
+        if (QDir(casoPath).exists()) {
+            cout << "Utilizando caso específico en: " << casoPath.toStdString() << endl;
+            procesarCaso(casoPath, dirSalida);
+        } else {
+            cout << "No se encontró un caso específico para procesar." << endl;
+            return 1;
+        }
+    } else {
+        int hilosDisponibles = opciones.hilos > 0 ? opciones.hilos : (int)thread::hardware_concurrency();
+        int numHilos = max(1, min(hilosDisponibles, (int)casos.size()));
+        // Con menos casos que hilos, los que sobran se usan dentro de cada caso
+        if (opciones.hilosCaso == 0) opciones.hilosCaso = max(1, hilosDisponibles / numHilos);
+
+        auto inicio = chrono::steady_clock::now();
+
+        if (numHilos == 1) {
+            // Procesar cada caso encontrado
+            for (const QString& caso : casos) {
+                QString rutaCaso = dirCasos.absolutePath() + "/" + caso;
+                cout << "\n\n========= Procesando caso: " << caso.toStdString() << " =========" << endl;
+                procesarCaso(rutaCaso, dirSalida + "/" + caso);
+            }
+        } else {
+            // Cada caso usa sus propios buffers y su propio directorio de salida, así que
+            // se pueden repartir entre los hilos sin compartir nada más que cout.
+            cout << "Procesando " << casos.size() << " casos con " << numHilos << " hilos" << endl;
+            mutex mtxSalida;
+            PoolHilos pool(numHilos);
+
+            for (const QString& caso : casos) {
+                pool.encolar([&, caso]() {
+                    ostringstream bufferCaso;
+                    ostream* registroAnterior = establecerRegistro(&bufferCaso);
+                    bufferCaso << "\n\n========= Procesando caso: " << caso.toStdString() << " =========" << endl;
+                    QString rutaCaso = dirCasos.absolutePath() + "/" + caso;
+                    procesarCaso(rutaCaso, dirSalida + "/" + caso);
+                    establecerRegistro(registroAnterior);
+
+                    // Volcar el registro completo del caso de una sola vez
+                    lock_guard<mutex> lock(mtxSalida);
+                    cout << bufferCaso.str() << flush;
+                });
+            }
+            pool.esperar();
+        }
+
+        double segundos = chrono::duration<double>(chrono::steady_clock::now() - inicio).count();
+        cout << "\n\n========= Resumen =========" << endl;
+        cout << "Casos procesados: " << casos.size() << " (" << casosExitosos << " exitosos, " << casosIncompletos
+             << " sin secuencia completa, " << (int)casos.size() - casosExitosos - casosIncompletos << " con error) con "
+             << numHilos << " hilos" << endl;
+        cout << "Tiempo total: " << segundos << " s" << endl;
+        cout << "Rendimiento: " << (segundos > 0 ? casos.size() / segundos : 0.0) << " casos/s" << endl;
+    }
+
+    // Los casos no esperan a sus volcados: se termina de escribirlos antes del resumen
+    escritor.esperar();
+    if (escritor.descartadas() > 0) {
+        cout << "Aviso: se descartaron " << escritor.descartadas()
+             << " imágenes de candidatos probados por superar el límite de memoria de la cola" << endl;
+    }
+    if (escritor.fallidas() > 0) {
+        cout << "Aviso: no se pudieron escribir " << escritor.fallidas() << " imágenes de diagnóstico" << endl;
+    }
+    if (!opciones.traza.isEmpty()) {
+        if (trazaGlobal.escribir(opciones.traza)) {
+            cout << "Traza guardada en: " << opciones.traza.toStdString() << endl;
+        } else {
+            cout << "Error: no se pudo escribir la traza en " << opciones.traza.toStdString() << endl;
+        }
+    }
+
+    if (casosExitosos < totalCasos) {
+        cout << "\n\nNo se pudieron resolver " << totalCasos - casosExitosos << " de " << totalCasos << " casos" << endl;
+        return 1;
+    }
+    cout << "\n\nTodos los casos han sido procesados exitosamente!" << endl;
+    return 0;
+}
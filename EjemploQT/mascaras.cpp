@@ -0,0 +1,187 @@
+// Archivos de enmascaramiento Mk.txt y su caché binaria Mk.mskbin
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QFileInfo>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+
+#include "aplicacion.h"
+
+using namespace std;
+
+// Cabecera del formato binario Mk.mskbin, seguida de cantidad * 3 valores uint16_t.
+// Guarda el tamaño y la fecha del .txt de origen para detectar cuando quedó desactualizado.
+// Los campos se escriben en el orden de bytes de la máquina; ordenBytes permite reconocer
+// (y descartar) un archivo generado en una máquina con el orden contrario.
+struct CabeceraMascaraBinaria {
+    char magia[4];          // "MSKB"
+    uint32_t version;       // 3 desde que la cabecera lleva ordenBytes
+    int64_t semilla;
+    uint32_t cantidad;
+    uint32_t ordenBytes;    // ORDEN_BYTES_MASCARA tal como lo escribió la máquina de origen
+    int64_t tamanoTexto;
+    int64_t fechaTexto;     // Milisegundos desde la época
+};
+static const uint32_t VERSION_MASCARA_BINARIA = 3;
+static const uint32_t ORDEN_BYTES_MASCARA = 0x01020304;
+
+static QString rutaMascaraBinaria(const QString& archivo) {
+    QFileInfo info(archivo);
+    return info.absolutePath() + "/" + info.completeBaseName() + ".mskbin";
+}
+
+// Intenta proyectar Mk.mskbin en memoria. Solo se acepta si la cabecera es válida y del mismo
+// orden de bytes, el tamaño cuadra con la cantidad declarada y el .txt de origen todavía existe
+// y no cambió desde que se generó (sin el .txt no hay con qué comprobar que siga vigente).
+static bool proyectarMascaraBinaria(const QString& rutaBinaria, const QFileInfo& infoTexto, DatosMascara& datos) {
+    if (!infoTexto.exists() || !QFile::exists(rutaBinaria)) return false;
+
+    unique_ptr<QFile> archivo(new QFile(rutaBinaria));
+    if (!archivo->open(QIODevice::ReadOnly) || archivo->size() < (long long)sizeof(CabeceraMascaraBinaria)) {
+        return false;
+    }
+    const unsigned char* base = archivo->map(0, archivo->size());
+    if (!base) return false;
+
+    CabeceraMascaraBinaria cabecera;
+    memcpy(&cabecera, base, sizeof(cabecera));
+    long long tamanoEsperado = (long long)sizeof(cabecera) + (long long)cabecera.cantidad * 3 * sizeof(uint16_t);
+    if (memcmp(cabecera.magia, "MSKB", 4) != 0 || cabecera.version != VERSION_MASCARA_BINARIA ||
+        cabecera.ordenBytes != ORDEN_BYTES_MASCARA ||
+        archivo->size() != tamanoEsperado || cabecera.cantidad > (uint32_t)INT32_MAX / 3 ||
+        cabecera.tamanoTexto != infoTexto.size() ||
+        cabecera.fechaTexto != infoTexto.lastModified().toMSecsSinceEpoch()) {
+        return false;
+    }
+
+    datos.semilla = cabecera.semilla;
+    datos.cantidad = cabecera.cantidad;
+    datos.sumas = reinterpret_cast<const uint16_t*>(base + sizeof(cabecera));
+    datos.archivoProyectado = std::move(archivo);
+    return true;
+}
+
+// Reemplaza 'destino' por 'origen' en un solo paso: quien abra 'destino' ve el archivo viejo o
+// el nuevo, nunca un hueco sin archivo
+bool reemplazarArchivo(const QString& origen, const QString& destino) {
+#ifdef _WIN32
+    QFile::remove(destino);  // En Windows rename no reemplaza un archivo existente
+#endif
+    return std::rename(QFile::encodeName(origen).constData(), QFile::encodeName(destino).constData()) == 0;
+}
+
+static void guardarMascaraBinaria(const QString& rutaBinaria, const QFileInfo& infoTexto, const DatosMascara& datos) {
+    CabeceraMascaraBinaria cabecera;
+    memcpy(cabecera.magia, "MSKB", 4);
+    cabecera.version = VERSION_MASCARA_BINARIA;
+    cabecera.semilla = datos.semilla;
+    cabecera.cantidad = datos.cantidad;
+    cabecera.ordenBytes = ORDEN_BYTES_MASCARA;
+    cabecera.tamanoTexto = infoTexto.size();
+    cabecera.fechaTexto = infoTexto.lastModified().toMSecsSinceEpoch();
+
+    // Se escribe en un temporal propio de este proceso e hilo y se renombra encima del anterior,
+    // para que nunca quede un .mskbin a medias ni dos escrituras pisen el mismo temporal
+    static atomic<int> numeroTemporal{0};
+    QString temporal = rutaBinaria + ".tmp" + QString::number(QCoreApplication::applicationPid()) + "_" +
+                       QString::number(numeroTemporal++);
+    QFile archivo(temporal);
+    if (!archivo.open(QIODevice::WriteOnly)) {
+        registro() << "Aviso: no se pudo crear " << temporal.toStdString() << endl;
+        return;
+    }
+    long long bytesDatos = (long long)datos.cantidad * 3 * sizeof(uint16_t);
+    bool ok = archivo.write((const char*)&cabecera, sizeof(cabecera)) == (long long)sizeof(cabecera) &&
+              archivo.write((const char*)datos.sumas, bytesDatos) == bytesDatos;
+    archivo.close();
+
+    if (!ok || !reemplazarArchivo(temporal, rutaBinaria)) {
+        registro() << "Aviso: no se pudo guardar " << rutaBinaria.toStdString() << endl;
+        QFile::remove(temporal);
+    }
+}
+
+bool cargarDatosEnmascaramiento(const QString& archivo, DatosMascara& datos, bool guardarCacheBinaria) {
+    QFileInfo infoTexto(archivo);
+    QString rutaBinaria = rutaMascaraBinaria(archivo);
+    if (proyectarMascaraBinaria(rutaBinaria, infoTexto, datos)) {
+        return true;
+    }
+
+    // Una sola pasada sobre el archivo proyectado en memoria, sin flujos ni releer el archivo
+    QFile f(archivo);
+    if(!f.open(QIODevice::ReadOnly) || f.size() == 0) {
+        registro() << "Error al abrir: " << archivo.toStdString() << endl;
+        return false;
+    }
+    const char* p = (const char*)f.map(0, f.size());
+    if(!p) {
+        registro() << "Error al abrir: " << archivo.toStdString() << endl;
+        return false;
+    }
+    const char* fin = p + f.size();
+
+    auto saltarEspacios = [&]() {
+        while (p < fin && (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t')) p++;
+    };
+
+    // Leer semilla
+    saltarEspacios();
+    auto [finSemilla, errSemilla] = from_chars(p, fin, datos.semilla);
+    if (errSemilla != errc()) {
+        registro() << "Error: semilla inválida en " << archivo.toStdString() << endl;
+        return false;
+    }
+    p = finSemilla;
+
+    // Cada valor ocupa al menos 2 caracteres ("0 "), así que esto alcanza para no realojar
+    datos.almacen.clear();
+    datos.almacen.reserve((fin - p) / 2 + 1);
+    while (true) {
+        saltarEspacios();
+        if (p >= fin) break;
+        uint16_t valor;
+        auto [siguiente, err] = from_chars(p, fin, valor);
+        if (err != errc()) {
+            registro() << "Error: valor inválido en " << archivo.toStdString() << endl;
+            return false;
+        }
+        datos.almacen.push_back(valor);
+        p = siguiente;
+    }
+
+    // Igual que antes, una tripleta incompleta al final se ignora
+    datos.cantidad = datos.almacen.size() / 3;
+    datos.almacen.resize(datos.cantidad * 3);
+    datos.sumas = datos.almacen.data();
+
+    if (guardarCacheBinaria) {
+        guardarMascaraBinaria(rutaBinaria, infoTexto, datos);
+    }
+    return true;
+}
+
+bool verificarEnmascaramiento(unsigned char* imagen, int anchoImagen, int altoImagen,
+                             const QString& archivoMascara, const QString& rutaSalida) {
+    // Cargar datos de enmascaramiento
+    DatosMascara datos;
+    if(!cargarDatosEnmascaramiento(archivoMascara, datos)) {
+        registro() << "Error al cargar el archivo de enmascaramiento" << endl;
+        return false;
+    }
+    long long totalPixeles = (long long)anchoImagen * altoImagen * 3;
+    unsigned char* imgVerificacion = new unsigned char[totalPixeles];
+    memcpy(imgVerificacion, imagen, totalPixeles);
+
+    // Aplicar enmascaramiento para verificar
+    aplicarEnmascaramiento(imgVerificacion, totalPixeles, datos);
+
+    // Guardar imagen verificada
+    guardarImagen(imgVerificacion, anchoImagen, altoImagen, rutaSalida);
+
+    delete[] imgVerificacion;
+
+    return true;
+}
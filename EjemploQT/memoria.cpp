@@ -0,0 +1,147 @@
+// Buffers de imagen: el PoolBuffers de cada hilo y la reserva con mmap de los buffers grandes
+
+#include <cstdlib>
+#ifdef __linux__
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "aplicacion.h"
+
+using namespace std;
+
+// Directorio de --memoria-disco (vacío = memoria anónima)
+static string dirMemoriaDisco;
+
+void establecerMemoriaDisco(const string& directorio)
+{
+    dirMemoriaDisco = directorio;
+}
+
+// Por encima de este tamaño los buffers se piden con mmap y en páginas enormes si se puede: una
+// imagen de varios GB en páginas de 4 KB son millones de fallos de página y de entradas de TLB
+static const size_t UMBRAL_MEMORIA_PROYECTADA = 64 << 20;
+static const size_t TAMANO_PAGINA_ENORME = 2 << 20;
+
+// Buffer proyectado de al menos 'tamano' bytes (se redondea a páginas enormes y se devuelve en
+// 'tamano'); nullptr si no se pudo, y entonces se usa new[]
+static unsigned char* reservarProyectado(size_t& tamano)
+{
+#ifdef __linux__
+    tamano = (tamano + TAMANO_PAGINA_ENORME - 1) / TAMANO_PAGINA_ENORME * TAMANO_PAGINA_ENORME;
+    void* p = MAP_FAILED;
+    if (!dirMemoriaDisco.empty()) {
+        // Archivo temporal que se borra en el acto: el espacio se libera al desproyectarlo
+        string plantilla = dirMemoriaDisco + "/reconstruccion-XXXXXX";
+        int fd = mkstemp(&plantilla[0]);
+        if (fd >= 0) {
+            unlink(plantilla.c_str());
+            if (ftruncate(fd, (off_t)tamano) == 0) {
+                p = mmap(nullptr, tamano, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            }
+            close(fd);
+        }
+        if (p != MAP_FAILED) return (unsigned char*)p;
+        static atomic<bool> avisado{false};
+        if (!avisado.exchange(true)) {
+            registro() << "Aviso: no se pudo usar " << dirMemoriaDisco << " para los buffers, se usa memoria" << endl;
+        }
+    }
+#ifdef MAP_HUGETLB
+    // Páginas enormes reservadas en el sistema (vm.nr_hugepages)
+    p = mmap(nullptr, tamano, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (p != MAP_FAILED) {
+        contarPerfil(CONTADOR_RESERVAS_PAGINAS_ENORMES);
+        return (unsigned char*)p;
+    }
+#endif
+    // Si no hay, páginas normales que el kernel puede agrupar solo (transparent huge pages)
+    p = mmap(nullptr, tamano, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) return nullptr;
+#ifdef MADV_HUGEPAGE
+    madvise(p, tamano, MADV_HUGEPAGE);
+#endif
+    return (unsigned char*)p;
+#else
+    (void)tamano;
+    return nullptr;
+#endif
+}
+
+static void liberarBloque(unsigned char* datos, size_t capacidad, bool proyectado)
+{
+#ifdef __linux__
+    if (proyectado) {
+        munmap(datos, capacidad);
+        return;
+    }
+#else
+    (void)capacidad;
+    (void)proyectado;
+#endif
+    delete[] datos;
+}
+
+PoolBuffers::~PoolBuffers()
+{
+    for (Bloque& b : bloques) {
+        liberarBloque(b.datos, b.capacidad, b.proyectado);
+    }
+}
+
+unsigned char* PoolBuffers::adquirir(size_t tamano)
+{
+    // El bloque libre más chico que alcance; si no hay, se reserva uno nuevo
+    Bloque* elegido = nullptr;
+    for (Bloque& b : bloques) {
+        if (!b.enUso && b.capacidad >= tamano && (!elegido || b.capacidad < elegido->capacidad)) {
+            elegido = &b;
+        }
+    }
+    if (!elegido) {
+        size_t capacidad = tamano;
+        unsigned char* datos = tamano >= UMBRAL_MEMORIA_PROYECTADA ? reservarProyectado(capacidad) : nullptr;
+        bool proyectado = datos != nullptr;
+        if (!proyectado) {
+            capacidad = tamano;
+            datos = new unsigned char[tamano];
+        }
+        bloques.push_back(Bloque{datos, capacidad, false, proyectado});
+        totalReservado += capacidad;
+        elegido = &bloques.back();
+        contarPerfil(CONTADOR_RESERVAS);
+    } else {
+        contarPerfil(CONTADOR_RESERVAS_REUTILIZADAS);
+    }
+    elegido->enUso = true;
+    return elegido->datos;
+}
+
+void PoolBuffers::liberar(unsigned char* buffer)
+{
+    if (!buffer) return;
+    size_t bytesLibres = 0;
+    for (Bloque& b : bloques) {
+        if (b.datos == buffer) b.enUso = false;
+        if (!b.enUso) bytesLibres += b.capacidad;
+    }
+
+    // No retener memoria sin límite: mientras los bloques libres pasen de MAX_BYTES_LIBRES se
+    // devuelve el más grande, que es el que más memoria retiene
+    while (bytesLibres > MAX_BYTES_LIBRES) {
+        auto mayor = bloques.end();
+        for (auto it = bloques.begin(); it != bloques.end(); ++it) {
+            if (!it->enUso && (mayor == bloques.end() || it->capacidad > mayor->capacidad)) mayor = it;
+        }
+        bytesLibres -= mayor->capacidad;
+        totalReservado -= mayor->capacidad;
+        liberarBloque(mayor->datos, mayor->capacidad, mayor->proyectado);
+        bloques.erase(mayor);
+    }
+}
+
+PoolBuffers& poolDelHilo()
+{
+    thread_local PoolBuffers pool;
+    return pool;
+}
@@ -0,0 +1,127 @@
+// Informes del perfilador: perfil.json de cada caso (--perfil) y la traza de todos (--traza)
+
+#include <algorithm>
+#include <cstdio>
+#include <iomanip>
+#include <sstream>
+
+#include "aplicacion.h"
+
+using namespace std;
+
+RegistroTraza trazaGlobal;
+
+string textoJson(const string& texto) {
+    // Comillas, barras y caracteres de control escapados; el resto (UTF-8 incluido) tal cual
+    string r = "\"";
+    for (char c : texto) {
+        unsigned char u = (unsigned char)c;
+        if (c == '"' || c == '\\') {
+            r += '\\';
+            r += c;
+        } else if (c == '\n') {
+            r += "\\n";
+        } else if (c == '\r') {
+            r += "\\r";
+        } else if (c == '\t') {
+            r += "\\t";
+        } else if (u < 0x20) {
+            char escape[8];
+            snprintf(escape, sizeof(escape), "\\u%04x", u);
+            r += escape;
+        } else {
+            r += c;
+        }
+    }
+    return r + "\"";
+}
+
+bool guardarResumenPerfil(const Perfilador& perfilador, const QString& archivo, const QString& caso, bool exito,
+                          const EstadisticasCaso& estadisticas)
+{
+    // Las fases se agrupan por nombre (llamadas y tiempo total); el orden es el de la primera vez
+    vector<const char*> nombres;
+    vector<pair<long, double>> totales;
+    for (const Perfilador::Fase& f : perfilador.obtenerFases()) {
+        size_t i = 0;
+        while (i < nombres.size() && strcmp(nombres[i], f.nombre) != 0) i++;
+        if (i == nombres.size()) {
+            nombres.push_back(f.nombre);
+            totales.push_back(make_pair(0L, 0.0));
+        }
+        totales[i].first++;
+        totales[i].second += f.duracionUs / 1000;
+    }
+
+    ostringstream json;
+    json << "{\n  \"caso\": " << textoJson(caso.toStdString()) << ",\n  \"exito\": " << (exito ? "true" : "false")
+         << ",\n  \"ancho\": " << estadisticas.ancho << ",\n  \"alto\": " << estadisticas.alto
+         << ",\n  \"pasos\": " << estadisticas.pasos
+         << ",\n  \"secuencia_completa\": " << (estadisticas.secuenciaCompleta ? "true" : "false")
+         << ",\n  \"estados\": " << estadisticas.estados << ",\n  \"fases\": {\n";
+    for (size_t i = 0; i < nombres.size(); i++) {
+        json << "    " << textoJson(nombres[i]) << ": {\"llamadas\": " << totales[i].first
+             << ", \"ms\": " << totales[i].second << "}" << (i + 1 < nombres.size() ? "," : "") << "\n";
+    }
+    json << "  },\n  \"contadores\": {\n";
+    for (int c = 0; c < NUM_CONTADORES; c++) {
+        json << "    " << textoJson(Perfilador::nombreContador((ContadorPerfil)c)) << ": " << perfilador.valor((ContadorPerfil)c)
+             << (c + 1 < NUM_CONTADORES ? "," : "") << "\n";
+    }
+    json << "  }\n}\n";
+
+    string texto = json.str();
+    QFile f(archivo);
+    return f.open(QIODevice::WriteOnly) && f.write(texto.data(), texto.size()) == (long long)texto.size();
+}
+
+static int indiceHilo()
+{
+    // Número corto y estable por hilo para el campo "tid" de la traza
+    static atomic<int> siguiente{0};
+    thread_local int indice = siguiente++;
+    return indice;
+}
+
+void RegistroTraza::agregar(const QString& caso, const Perfilador& perfilador)
+{
+    vector<string> nuevos;
+    string argumentos = "{\"caso\": " + textoJson(caso.toStdString()) + "}";
+    int hilo = indiceHilo();
+    double finUs = 0;
+    for (const Perfilador::Fase& f : perfilador.obtenerFases()) {
+        ostringstream evento;
+        evento << fixed << setprecision(3);  // Microsegundos: sin notación científica en corridas largas
+        evento << "{\"name\": " << textoJson(f.nombre) << ", \"cat\": \"reconstruccion\", \"ph\": \"X\", \"ts\": "
+               << f.inicioUs << ", \"dur\": " << f.duracionUs << ", \"pid\": 1, \"tid\": " << hilo
+               << ", \"args\": " << argumentos << "}";
+        nuevos.push_back(evento.str());
+        finUs = max(finUs, f.inicioUs + f.duracionUs);
+    }
+    // Los contadores del caso como un evento de contador al final
+    ostringstream contadores;
+    contadores << fixed << setprecision(3) << "{\"name\": " << textoJson("contadores " + caso.toStdString())
+               << ", \"ph\": \"C\", \"ts\": " << finUs << ", \"pid\": 1, \"args\": {";
+    for (int c = 0; c < NUM_CONTADORES; c++) {
+        contadores << (c ? ", " : "") << textoJson(Perfilador::nombreContador((ContadorPerfil)c)) << ": "
+                   << perfilador.valor((ContadorPerfil)c);
+    }
+    contadores << "}}";
+    nuevos.push_back(contadores.str());
+
+    lock_guard<mutex> lock(mtx);
+    eventos.insert(eventos.end(), nuevos.begin(), nuevos.end());
+}
+
+bool RegistroTraza::escribir(const QString& archivo)
+{
+    lock_guard<mutex> lock(mtx);
+    string texto = "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+    for (size_t i = 0; i < eventos.size(); i++) {
+        texto += eventos[i];
+        texto += (i + 1 < eventos.size()) ? ",\n" : "\n";
+    }
+    texto += "]}\n";
+    QFile f(archivo);
+    return f.open(QIODevice::WriteOnly) && f.write(texto.data(), texto.size()) == (long long)texto.size();
+}
@@ -0,0 +1,7 @@
+# Búsqueda de la secuencia sobre casos sintéticos en memoria
+TEMPLATE = app
+TARGET = prueba_busqueda
+CONFIG += console c++17 testcase
+CONFIG -= qt app_bundle
+include(../../reconstruccion.pri)
+SOURCES += prueba_busqueda.cpp
@@ -0,0 +1,183 @@
+// Búsqueda de la secuencia sobre casos generados en memoria con una secuencia conocida, igual
+// que --generar pero sin archivos: cada paso anota la ventana de su semilla sumada con la
+// máscara y después aplica su transformación.
+
+#include "reconstruccion_interna.h"
+
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+struct CasoSintetico {
+    vector<unsigned char> imagenFinal;
+    vector<unsigned char> auxiliar;
+    vector<unsigned char> mascara;
+    vector<RestriccionMascara> restricciones;
+    vector<vector<uint16_t>> sumas;
+
+    CasoEnMemoria caso() const {
+        CasoEnMemoria c;
+        c.imagenFinal = imagenFinal.data();
+        c.imagenAuxiliar = auxiliar.data();
+        c.totalPixeles = imagenFinal.size();
+        c.mascara = mascara.data();
+        c.bytesMascara = mascara.size();
+        for (const RestriccionMascara& r : restricciones) c.restricciones.push_back(&r);
+        return c;
+    }
+};
+
+static CasoSintetico generar(const vector<Transformacion>& secuencia, long long totalPixeles, int bytesMascara,
+                             unsigned int semilla)
+{
+    mt19937_64 generador(semilla);
+    CasoSintetico c;
+    vector<unsigned char> estado(totalPixeles);
+    c.auxiliar.resize(totalPixeles);
+    c.mascara.resize(bytesMascara);
+    for (long long i = 0; i < totalPixeles; i++) {
+        estado[i] = generador() & 0xFF;
+        c.auxiliar[i] = generador() & 0xFF;
+    }
+    for (int j = 0; j < bytesMascara; j++) c.mascara[j] = generador() & 0xFF;
+
+    uniform_int_distribution<long long> posicion(0, totalPixeles - 1);
+    c.sumas.resize(secuencia.size());
+    c.restricciones.resize(secuencia.size());
+    for (size_t k = 0; k < secuencia.size(); k++) {
+        c.restricciones[k].semilla = posicion(generador);
+        c.restricciones[k].cantidad = bytesMascara / 3;
+        for (int j = 0; j < bytesMascara; j++) {
+            c.sumas[k].push_back(estado[(c.restricciones[k].semilla + j) % totalPixeles] + c.mascara[j]);
+        }
+        c.restricciones[k].sumas = c.sumas[k].data();
+        aplicarTransformacion(estado.data(), estado.data(), totalPixeles, secuencia[k], c.auxiliar.data());
+    }
+    c.imagenFinal = estado;
+    return c;
+}
+
+// El mismo caso en el modo por bloques: la ventana de cada paso, copiada desde la semilla (puede
+// dar la vuelta), y el histograma conjunto, como los arma analizarPorBloques en caso.cpp
+struct CasoPorBloques {
+    vector<uint64_t> histograma;
+    vector<vector<unsigned char>> ventanasFinal, ventanasAuxiliar;
+
+    CasoEnMemoria caso(const CasoEnMemoria& enMemoria) {
+        CasoEnMemoria c = enMemoria;
+        c.imagenFinal = nullptr;
+        c.imagenAuxiliar = nullptr;
+        histograma.assign(256 * 256, 0);
+        for (long long i = 0; i < c.totalPixeles; i++) {
+            histograma[enMemoria.imagenFinal[i] * 256 + enMemoria.imagenAuxiliar[i]]++;
+        }
+        ventanasFinal.assign(c.restricciones.size(), vector<unsigned char>());
+        ventanasAuxiliar.assign(c.restricciones.size(), vector<unsigned char>());
+        for (size_t paso = 0; paso < c.restricciones.size(); paso++) {
+            if (c.restricciones[paso]) {
+                for (int j = 0; j < bytesVentanaPaso(c, paso); j++) {
+                    long long posicion = (c.restricciones[paso]->semilla + j) % c.totalPixeles;
+                    ventanasFinal[paso].push_back(enMemoria.imagenFinal[posicion]);
+                    ventanasAuxiliar[paso].push_back(enMemoria.imagenAuxiliar[posicion]);
+                }
+            }
+            c.ventanasFinal.push_back(ventanasFinal[paso].data());
+            c.ventanasAuxiliar.push_back(ventanasAuxiliar[paso].data());
+        }
+        c.histograma = histograma.data();
+        return c;
+    }
+};
+
+static int fallos = 0;
+
+static void comprobar(bool condicion, const string& descripcion)
+{
+    cout << (condicion ? "OK    " : "FALLO ") << descripcion << endl;
+    if (!condicion) fallos++;
+}
+
+static bool mismasSecuencias(const vector<Transformacion>& a, const vector<Transformacion>& b)
+{
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); i++) {
+        if (a[i].tipo != b[i].tipo || a[i].bits != b[i].bits) return false;
+    }
+    return true;
+}
+
+static void compararModos(const CasoEnMemoria& caso, const string& descripcion)
+{
+    // Leído por bloques, el caso tiene que dar la misma secuencia que con las imágenes completas
+    CasoPorBloques porBloques;
+    ResultadoSecuencia enMemoria, streaming;
+    detectarSecuencia(caso, enMemoria);
+    detectarSecuencia(porBloques.caso(caso), streaming);
+    comprobar(enMemoria.completa == streaming.completa && mismasSecuencias(enMemoria.secuencia, streaming.secuencia),
+              descripcion + ": misma secuencia en memoria y por bloques");
+}
+
+static bool tieneNinguna(const vector<Transformacion>& secuencia)
+{
+    for (const Transformacion& t : secuencia) {
+        if (t.tipo == NINGUNA) return true;
+    }
+    return false;
+}
+
+int main()
+{
+    const vector<Transformacion> secuencia = {
+        {XOR_CON_IM, 0}, {ROTACION_DERECHA, 3}, {DESPLAZAMIENTO_IZQUIERDA, 1}, {XOR_CON_IM, 0}, {ROTACION_IZQUIERDA, 5}};
+    const long long totalPixeles = 64 * 48 * 3;
+    const int bytesMascara = 10 * 10 * 3;
+
+    {
+        CasoSintetico c = generar(secuencia, totalPixeles, bytesMascara, 1);
+        ResultadoSecuencia resultado;
+        bool completa = detectarSecuencia(c.caso(), resultado);
+        comprobar(completa && resultado.completa && !tieneNinguna(resultado.secuencia), "caso completo");
+        comprobar(verificarSecuencia(c.caso(), resultado.secuencia), "la secuencia encontrada cumple las máscaras");
+        compararModos(c.caso(), "caso completo");
+    }
+
+    {
+        // Sin M0.txt el primer paso no se puede identificar: la secuencia no está completa
+        // aunque el resto cumpla sus máscaras
+        CasoSintetico c = generar(secuencia, totalPixeles, bytesMascara, 2);
+        CasoEnMemoria caso = c.caso();
+        caso.restricciones[0] = nullptr;
+        ResultadoSecuencia resultado;
+        bool completa = detectarSecuencia(caso, resultado);
+        comprobar(!completa && !resultado.completa, "sin M0.txt la secuencia no está completa");
+        comprobar(resultado.secuencia.size() == secuencia.size() && resultado.secuencia[0].tipo == NINGUNA,
+                  "sin M0.txt el paso 1 queda sin identificar");
+        compararModos(caso, "sin M0.txt");
+    }
+
+    {
+        // Un Mk.txt con semilla pero sin tripletas deja una ventana de 0 bytes: el paso no tiene
+        // restricción, igual que si faltara el archivo
+        CasoSintetico c = generar(secuencia, totalPixeles, bytesMascara, 3);
+        c.restricciones[2].cantidad = 0;
+        ResultadoSecuencia resultado;
+        detectarSecuencia(c.caso(), resultado);
+        comprobar(!resultado.completa && resultado.secuencia[2].tipo == NINGUNA,
+                  "M2.txt sin tripletas deja el paso 3 sin identificar");
+        compararModos(c.caso(), "M2.txt sin tripletas");
+    }
+
+    {
+        // Con M vacía ninguna ventana restringe nada
+        CasoSintetico c = generar(secuencia, totalPixeles, 0, 4);
+        ResultadoSecuencia resultado;
+        detectarSecuencia(c.caso(), resultado);
+        comprobar(!resultado.completa && resultado.secuencia.size() == secuencia.size() &&
+                  resultado.secuencia[0].tipo == NINGUNA, "con M vacía ningún paso queda identificado");
+        compararModos(c.caso(), "M vacía");
+    }
+
+    return fallos == 0 ? 0 : 1;
+}
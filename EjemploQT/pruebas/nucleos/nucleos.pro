@@ -0,0 +1,7 @@
+# Núcleos SIMD contra la referencia escalar
+TEMPLATE = app
+TARGET = prueba_nucleos
+CONFIG += console c++17 testcase
+CONFIG -= qt app_bundle
+include(../../reconstruccion.pri)
+SOURCES += prueba_nucleos.cpp
@@ -0,0 +1,96 @@
+// Compara cada núcleo disponible en esta CPU contra el escalar, en todas las operaciones y con
+// las 8 cantidades de bits (0 a 7). Se prueban largos que no son múltiplo de 16, 32 ni 64 para
+// cubrir las colas, y varios desplazamientos de inicio para cubrir accesos no alineados.
+
+#include "reconstruccion_interna.h"
+
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+static bool compararNucleo(const NucleosBytes& escalar, const NucleosBytes& candidato)
+{
+    const int maximo = 4096 + 37;
+    vector<unsigned char> entrada(maximo + 64), auxiliar(maximo + 64), esperado(maximo), obtenido(maximo);
+    mt19937 generador(12345);
+    for (size_t i = 0; i < entrada.size(); i++) {
+        entrada[i] = generador() & 0xFF;
+        auxiliar[i] = generador() & 0xFF;
+    }
+    unsigned char tablas[4][16];
+    for (int k = 0; k < 4; k++) {
+        for (int v = 0; v < 16; v++) tablas[k][v] = generador() & 0xFF;
+    }
+
+    bool correcto = true;
+    auto comparar = [&](long long n, const string& operacion, int inicio) {
+        if (memcmp(esperado.data(), obtenido.data(), n) != 0) {
+            cout << "  " << candidato.nombre << ": " << operacion << " difiere (largo " << n << ", inicio "
+                 << inicio << ")" << endl;
+            correcto = false;
+        }
+    };
+
+    const long long largos[] = {0, 1, 7, 15, 16, 17, 31, 33, 63, 64, 65, 127, 129, 255, 1000, maximo};
+    for (long long n : largos) {
+        for (int inicio : {0, 1, 2, 3, 5, 13, 31, 63}) {
+            const unsigned char* e = entrada.data() + inicio;
+            const unsigned char* a = auxiliar.data() + (63 - inicio);
+
+            escalar.xorBytes(e, a, esperado.data(), n);
+            candidato.xorBytes(e, a, obtenido.data(), n);
+            comparar(n, "XOR", inicio);
+
+            for (const unsigned char* aux : {(const unsigned char*)nullptr, a}) {
+                escalar.tablasNibbles(e, aux, esperado.data(), n, tablas);
+                candidato.tablasNibbles(e, aux, obtenido.data(), n, tablas);
+                comparar(n, aux ? "tablas por nibble con auxiliar" : "tablas por nibble sin auxiliar", inicio);
+            }
+
+            for (int bits = 0; bits < 8; bits++) {
+                struct { const char* operacion; void (*ref)(const unsigned char*, unsigned char*, long long, int);
+                         void (*simd)(const unsigned char*, unsigned char*, long long, int); } pruebas[] = {
+                    {"rotación derecha", escalar.rotarDerecha, candidato.rotarDerecha},
+                    {"rotación izquierda", escalar.rotarIzquierda, candidato.rotarIzquierda},
+                    {"desplazamiento derecha", escalar.desplazarDerecha, candidato.desplazarDerecha},
+                    {"desplazamiento izquierda", escalar.desplazarIzquierda, candidato.desplazarIzquierda},
+                };
+                for (const auto& prueba : pruebas) {
+                    prueba.ref(e, esperado.data(), n, bits);
+                    prueba.simd(e, obtenido.data(), n, bits);
+                    comparar(n, string(prueba.operacion) + " " + to_string(bits) + " bits", inicio);
+                }
+            }
+
+            // Planos de bits: se comparan contra la definición, no solo contra el escalar
+            for (long long bloque = 0; bloque + 64 <= n; bloque += 64) {
+                uint64_t planos[8];
+                candidato.planosBits(e + bloque, planos);
+                for (int k = 0; k < 64 * 8; k++) {
+                    if (((planos[k % 8] >> (k / 8)) & 1) != (uint64_t)((e[bloque + k / 8] >> (k % 8)) & 1)) {
+                        cout << "  " << candidato.nombre << ": planos de bits difieren (inicio " << inicio << ")" << endl;
+                        correcto = false;
+                        break;
+                    }
+                }
+            }
+        }
+    }
+    return correcto;
+}
+
+int main()
+{
+    // El primero de la lista es siempre el escalar, la referencia
+    vector<const NucleosBytes*> disponibles = nucleosDisponibles();
+    bool todoCorrecto = true;
+    for (const NucleosBytes* candidato : disponibles) {
+        bool correcto = compararNucleo(*disponibles.front(), *candidato);
+        cout << "Núcleos " << candidato->nombre << ": " << (correcto ? "OK" : "FALLO") << endl;
+        todoCorrecto = todoCorrecto && correcto;
+    }
+    return todoCorrecto ? 0 : 1;
+}
@@ -0,0 +1,4 @@
+# Pruebas de la biblioteca de reconstrucción, sin Qt. Se compilan con qmake y se corren con
+# "make check": cada una termina con código distinto de cero si algo falla.
+TEMPLATE = subdirs
+SUBDIRS = nucleos busqueda
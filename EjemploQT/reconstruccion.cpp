@@ -0,0 +1,1314 @@
+#include "reconstruccion_interna.h"
+
+#include <algorithm>
+#include <cstring>
+#include <chrono>
+#include <memory>
+#include <ostream>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define NUCLEOS_SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+// Flujo de registro del hilo actual. Por defecto ninguno: una biblioteca integrada en otro
+// programa no escribe en cout por su cuenta. La aplicación elige el flujo de cada hilo (cout,
+// o el búfer de cada caso en modo paralelo para que sus líneas no se mezclen).
+static thread_local ostream* flujoRegistro = nullptr;
+
+thread_local Perfilador* perfiladorActual = nullptr;
+
+ostream* establecerRegistro(ostream* flujo)
+{
+    ostream* anterior = flujoRegistro;
+    flujoRegistro = flujo;
+    return anterior;
+}
+
+ostream& registro()
+{
+    // Sin búfer de salida el flujo queda en error y descarta todo lo que se le escribe
+    static thread_local ostream sumidero(nullptr);
+    return flujoRegistro ? *flujoRegistro : sumidero;
+}
+
+PoolHilos::PoolHilos(int numHilos) : contadoresTareas(NUM_CONTADORES, 0)
+{
+    for (int i = 0; i < numHilos; i++) {
+        hilos.emplace_back([this]() { bucleTrabajador(); });
+    }
+}
+
+PoolHilos::~PoolHilos()
+{
+    {
+        lock_guard<mutex> lock(mtx);
+        detener = true;
+    }
+    hayTarea.notify_all();
+    for (thread& h : hilos) {
+        h.join();
+    }
+}
+
+void PoolHilos::encolar(function<void()> tarea)
+{
+    {
+        lock_guard<mutex> lock(mtx);
+        tareas.push(Tarea{std::move(tarea), perfiladorActual != nullptr});
+        pendientes++;
+    }
+    hayTarea.notify_one();
+}
+
+void PoolHilos::esperar()
+{
+    unique_lock<mutex> lock(mtx);
+    sinPendientes.wait(lock, [this]() { return pendientes == 0; });
+    if (!perfiladorActual) return;
+    for (int c = 0; c < NUM_CONTADORES; c++) {
+        perfiladorActual->contar((ContadorPerfil)c, contadoresTareas[c]);
+        contadoresTareas[c] = 0;
+    }
+}
+
+double microsegundosDesdeInicio()
+{
+    static const chrono::steady_clock::time_point arranque = chrono::steady_clock::now();
+    return chrono::duration<double, micro>(chrono::steady_clock::now() - arranque).count();
+}
+
+void Perfilador::registrarFase(const char* nombre, double inicioUs, double duracionUs)
+{
+    fases.push_back(Fase{nombre, inicioUs, duracionUs});
+}
+
+const char* Perfilador::nombreContador(ContadorPerfil contador)
+{
+    switch (contador) {
+        case CONTADOR_CANDIDATOS_VERIFICADOS: return "candidatos_verificados";
+        case CONTADOR_CANDIDATOS_DESCARTADOS: return "candidatos_descartados";
+        case CONTADOR_CORTES_TEMPRANOS: return "cortes_tempranos";
+        case CONTADOR_BYTES_RECORRIDOS: return "bytes_recorridos";
+        case CONTADOR_BYTES_ES: return "bytes_entrada_salida";
+        case CONTADOR_RESERVAS: return "reservas";
+        case CONTADOR_RESERVAS_REUTILIZADAS: return "reservas_reutilizadas";
+        case CONTADOR_RESERVAS_PAGINAS_ENORMES: return "reservas_paginas_enormes";
+        case CONTADOR_IMAGENES_VOLCADAS: return "imagenes_volcadas";
+        default: return "?";
+    }
+}
+
+TemporizadorFase::TemporizadorFase(const char* nombre) : nombre(nombre), perfilador(perfiladorActual)
+{
+    if (perfilador) inicioUs = microsegundosDesdeInicio();
+}
+
+void TemporizadorFase::terminar()
+{
+    if (perfilador) perfilador->registrarFase(nombre, inicioUs, microsegundosDesdeInicio() - inicioUs);
+    perfilador = nullptr;
+}
+
+void PoolHilos::bucleTrabajador()
+{
+    while (true) {
+        Tarea tarea;
+        {
+            unique_lock<mutex> lock(mtx);
+            hayTarea.wait(lock, [this]() { return detener || !tareas.empty(); });
+            if (detener && tareas.empty()) return;
+            tarea = std::move(tareas.front());
+            tareas.pop();
+        }
+
+        Perfilador perfiladorTarea;
+        if (tarea.medir) perfiladorActual = &perfiladorTarea;
+        tarea.funcion();
+        perfiladorActual = nullptr;
+
+        lock_guard<mutex> lock(mtx);
+        if (tarea.medir) {
+            for (int c = 0; c < NUM_CONTADORES; c++) contadoresTareas[c] += perfiladorTarea.valor((ContadorPerfil)c);
+        }
+        if (--pendientes == 0) sinPendientes.notify_all();
+    }
+}
+
+
+unsigned char rotarDerecha(unsigned char valor, int bits) {
+    return (valor >> bits) | (valor << (8 - bits));
+}
+
+unsigned char rotarIzquierda(unsigned char valor, int bits) {
+    return (valor << bits) | (valor >> (8 - bits));
+}
+
+unsigned char desplazarDerecha(unsigned char valor, int bits) {
+    return valor >> bits;
+}
+
+unsigned char desplazarIzquierda(unsigned char valor, int bits) {
+    return valor << bits;
+}
+
+// ---- Núcleos escalares (referencia) ----
+
+static void xorBytesEscalar(const unsigned char* entrada, const unsigned char* auxiliar, unsigned char* salida, long long n) {
+    for(long long i = 0; i < n; i++) {
+        salida[i] = entrada[i] ^ auxiliar[i];
+    }
+}
+
+static void rotarDerechaEscalar(const unsigned char* entrada, unsigned char* salida, long long n, int bits) {
+    for(long long i = 0; i < n; i++) {
+        salida[i] = rotarDerecha(entrada[i], bits);
+    }
+}
+
+static void rotarIzquierdaEscalar(const unsigned char* entrada, unsigned char* salida, long long n, int bits) {
+    for(long long i = 0; i < n; i++) {
+        salida[i] = rotarIzquierda(entrada[i], bits);
+    }
+}
+
+static void desplazarDerechaEscalar(const unsigned char* entrada, unsigned char* salida, long long n, int bits) {
+    for(long long i = 0; i < n; i++) {
+        salida[i] = desplazarDerecha(entrada[i], bits);
+    }
+}
+
+static void desplazarIzquierdaEscalar(const unsigned char* entrada, unsigned char* salida, long long n, int bits) {
+    for(long long i = 0; i < n; i++) {
+        salida[i] = desplazarIzquierda(entrada[i], bits);
+    }
+}
+
+static void tablasNibblesEscalar(const unsigned char* entrada, const unsigned char* auxiliar, unsigned char* salida,
+                                 long long n, const unsigned char (*tablas)[16]) {
+    if (!auxiliar) {
+        for(long long i = 0; i < n; i++) {
+            salida[i] = tablas[0][entrada[i] & 15] ^ tablas[1][entrada[i] >> 4];
+        }
+        return;
+    }
+    for(long long i = 0; i < n; i++) {
+        salida[i] = tablas[0][entrada[i] & 15] ^ tablas[1][entrada[i] >> 4] ^
+                    tablas[2][auxiliar[i] & 15] ^ tablas[3][auxiliar[i] >> 4];
+    }
+}
+
+static inline int contarUnos(uint64_t v) {
+#ifdef __GNUC__
+    return __builtin_popcountll(v);
+#else
+    v = v - ((v >> 1) & 0x5555555555555555ULL);
+    v = (v & 0x3333333333333333ULL) + ((v >> 2) & 0x3333333333333333ULL);
+    v = (v + (v >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return (int)((v * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+static void planosBitsEscalar(const unsigned char* bloque, uint64_t* planos) {
+    // Transposición de matrices de 8x8 bits con tres intercambios de bloques (Hacker's Delight):
+    // cada grupo de 8 bytes aporta un byte a cada plano
+    for (int b = 0; b < 8; b++) planos[b] = 0;
+    for (int g = 0; g < 8; g++) {
+        uint64_t x = 0;
+        for (int k = 0; k < 8; k++) x |= (uint64_t)bloque[g * 8 + k] << (8 * k);
+        uint64_t t;
+        t = (x ^ (x >> 7)) & 0x00AA00AA00AA00AAULL;  x ^= t ^ (t << 7);
+        t = (x ^ (x >> 14)) & 0x0000CCCC0000CCCCULL; x ^= t ^ (t << 14);
+        t = (x ^ (x >> 28)) & 0x00000000F0F0F0F0ULL; x ^= t ^ (t << 28);
+        for (int b = 0; b < 8; b++) planos[b] |= ((x >> (8 * b)) & 0xFF) << (8 * g);
+    }
+}
+
+static const NucleosBytes nucleosEscalares = {
+    "escalar", xorBytesEscalar, rotarDerechaEscalar, rotarIzquierdaEscalar,
+    desplazarDerechaEscalar, desplazarIzquierdaEscalar, tablasNibblesEscalar, planosBitsEscalar
+};
+
+#ifdef NUCLEOS_SIMD_X86
+// No hay desplazamientos de 8 bits en x86: se desplaza en carriles de 16 bits y se enmascaran
+// los bits que pasan de un byte al vecino. Una rotación es la unión de los dos desplazamientos.
+// La cantidad de bits va en un registro (srl/sll) porque solo se conoce en tiempo de ejecución.
+
+// ---- SSE2 ----
+
+__attribute__((target("sse2")))
+static void xorBytesSse2(const unsigned char* entrada, const unsigned char* auxiliar, unsigned char* salida, long long n) {
+    long long i = 0;
+    for(; i + 16 <= n; i += 16) {
+        __m128i a = _mm_loadu_si128((const __m128i*)(entrada + i));
+        __m128i b = _mm_loadu_si128((const __m128i*)(auxiliar + i));
+        _mm_storeu_si128((__m128i*)(salida + i), _mm_xor_si128(a, b));
+    }
+    xorBytesEscalar(entrada + i, auxiliar + i, salida + i, n - i);
+}
+
+__attribute__((target("sse2")))
+static void rotarDerechaSse2(const unsigned char* entrada, unsigned char* salida, long long n, int bits) {
+    __m128i cuentaDer = _mm_cvtsi32_si128(bits);
+    __m128i cuentaIzq = _mm_cvtsi32_si128(8 - bits);
+    __m128i mascaraDer = _mm_set1_epi8((char)(0xFF >> bits));
+    __m128i mascaraIzq = _mm_set1_epi8((char)(0xFF << (8 - bits)));
+    long long i = 0;
+    for(; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(entrada + i));
+        __m128i der = _mm_and_si128(_mm_srl_epi16(v, cuentaDer), mascaraDer);
+        __m128i izq = _mm_and_si128(_mm_sll_epi16(v, cuentaIzq), mascaraIzq);
+        _mm_storeu_si128((__m128i*)(salida + i), _mm_or_si128(der, izq));
+    }
+    rotarDerechaEscalar(entrada + i, salida + i, n - i, bits);
+}
+
+__attribute__((target("sse2")))
+static void rotarIzquierdaSse2(const unsigned char* entrada, unsigned char* salida, long long n, int bits) {
+    rotarDerechaSse2(entrada, salida, n, (8 - bits) & 7);
+}
+
+__attribute__((target("sse2")))
+static void desplazarDerechaSse2(const unsigned char* entrada, unsigned char* salida, long long n, int bits) {
+    __m128i cuenta = _mm_cvtsi32_si128(bits);
+    __m128i mascara = _mm_set1_epi8((char)(0xFF >> bits));
+    long long i = 0;
+    for(; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(entrada + i));
+        _mm_storeu_si128((__m128i*)(salida + i), _mm_and_si128(_mm_srl_epi16(v, cuenta), mascara));
+    }
+    desplazarDerechaEscalar(entrada + i, salida + i, n - i, bits);
+}
+
+__attribute__((target("sse2")))
+static void desplazarIzquierdaSse2(const unsigned char* entrada, unsigned char* salida, long long n, int bits) {
+    __m128i cuenta = _mm_cvtsi32_si128(bits);
+    __m128i mascara = _mm_set1_epi8((char)(0xFF << bits));
+    long long i = 0;
+    for(; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(entrada + i));
+        _mm_storeu_si128((__m128i*)(salida + i), _mm_and_si128(_mm_sll_epi16(v, cuenta), mascara));
+    }
+    desplazarIzquierdaEscalar(entrada + i, salida + i, n - i, bits);
+}
+
+__attribute__((target("sse2")))
+static void planosBitsSse2(const unsigned char* bloque, uint64_t* planos) {
+    // movemask toma el bit alto de cada byte: se sube el bit b a esa posición
+    __m128i v[4];
+    for (int q = 0; q < 4; q++) v[q] = _mm_loadu_si128((const __m128i*)(bloque + 16 * q));
+    for (int b = 0; b < 8; b++) {
+        __m128i cuenta = _mm_cvtsi32_si128(7 - b);
+        uint64_t plano = 0;
+        for (int q = 0; q < 4; q++) {
+            plano |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_sll_epi16(v[q], cuenta)) << (16 * q);
+        }
+        planos[b] = plano;
+    }
+}
+
+// pshufb es SSSE3, así que en el nivel SSE2 las tablas se aplican con el núcleo escalar
+static const NucleosBytes nucleosSse2 = {
+    "sse2", xorBytesSse2, rotarDerechaSse2, rotarIzquierdaSse2,
+    desplazarDerechaSse2, desplazarIzquierdaSse2, tablasNibblesEscalar, planosBitsSse2
+};
+
+// ---- AVX2 ----
+
+__attribute__((target("avx2")))
+static void xorBytesAvx2(const unsigned char* entrada, const unsigned char* auxiliar, unsigned char* salida, long long n) {
+    long long i = 0;
+    for(; i + 32 <= n; i += 32) {
+        __m256i a = _mm256_loadu_si256((const __m256i*)(entrada + i));
+        __m256i b = _mm256_loadu_si256((const __m256i*)(auxiliar + i));
+        _mm256_storeu_si256((__m256i*)(salida + i), _mm256_xor_si256(a, b));
+    }
+    xorBytesEscalar(entrada + i, auxiliar + i, salida + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static void rotarDerechaAvx2(const unsigned char* entrada, unsigned char* salida, long long n, int bits) {
+    __m128i cuentaDer = _mm_cvtsi32_si128(bits);
+    __m128i cuentaIzq = _mm_cvtsi32_si128(8 - bits);
+    __m256i mascaraDer = _mm256_set1_epi8((char)(0xFF >> bits));
+    __m256i mascaraIzq = _mm256_set1_epi8((char)(0xFF << (8 - bits)));
+    long long i = 0;
+    for(; i + 32 <= n; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(entrada + i));
+        __m256i der = _mm256_and_si256(_mm256_srl_epi16(v, cuentaDer), mascaraDer);
+        __m256i izq = _mm256_and_si256(_mm256_sll_epi16(v, cuentaIzq), mascaraIzq);
+        _mm256_storeu_si256((__m256i*)(salida + i), _mm256_or_si256(der, izq));
+    }
+    rotarDerechaEscalar(entrada + i, salida + i, n - i, bits);
+}
+
+__attribute__((target("avx2")))
+static void rotarIzquierdaAvx2(const unsigned char* entrada, unsigned char* salida, long long n, int bits) {
+    rotarDerechaAvx2(entrada, salida, n, (8 - bits) & 7);
+}
+
+__attribute__((target("avx2")))
+static void desplazarDerechaAvx2(const unsigned char* entrada, unsigned char* salida, long long n, int bits) {
+    __m128i cuenta = _mm_cvtsi32_si128(bits);
+    __m256i mascara = _mm256_set1_epi8((char)(0xFF >> bits));
+    long long i = 0;
+    for(; i + 32 <= n; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(entrada + i));
+        _mm256_storeu_si256((__m256i*)(salida + i), _mm256_and_si256(_mm256_srl_epi16(v, cuenta), mascara));
+    }
+    desplazarDerechaEscalar(entrada + i, salida + i, n - i, bits);
+}
+
+__attribute__((target("avx2")))
+static void desplazarIzquierdaAvx2(const unsigned char* entrada, unsigned char* salida, long long n, int bits) {
+    __m128i cuenta = _mm_cvtsi32_si128(bits);
+    __m256i mascara = _mm256_set1_epi8((char)(0xFF << bits));
+    long long i = 0;
+    for(; i + 32 <= n; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(entrada + i));
+        _mm256_storeu_si256((__m256i*)(salida + i), _mm256_and_si256(_mm256_sll_epi16(v, cuenta), mascara));
+    }
+    desplazarIzquierdaEscalar(entrada + i, salida + i, n - i, bits);
+}
+
+__attribute__((target("avx2")))
+static void tablasNibblesAvx2(const unsigned char* entrada, const unsigned char* auxiliar, unsigned char* salida,
+                              long long n, const unsigned char (*tablas)[16]) {
+    __m256i nibble = _mm256_set1_epi8(0x0F);
+    __m256i t[4];
+    for (int k = 0; k < (auxiliar ? 4 : 2); k++) {
+        t[k] = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)tablas[k]));
+    }
+    long long i = 0;
+    for(; i + 32 <= n; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(entrada + i));
+        __m256i r = _mm256_xor_si256(
+            _mm256_shuffle_epi8(t[0], _mm256_and_si256(v, nibble)),
+            _mm256_shuffle_epi8(t[1], _mm256_and_si256(_mm256_srli_epi16(v, 4), nibble)));
+        if (auxiliar) {
+            __m256i a = _mm256_loadu_si256((const __m256i*)(auxiliar + i));
+            r = _mm256_xor_si256(r, _mm256_xor_si256(
+                _mm256_shuffle_epi8(t[2], _mm256_and_si256(a, nibble)),
+                _mm256_shuffle_epi8(t[3], _mm256_and_si256(_mm256_srli_epi16(a, 4), nibble))));
+        }
+        _mm256_storeu_si256((__m256i*)(salida + i), r);
+    }
+    tablasNibblesEscalar(entrada + i, auxiliar ? auxiliar + i : nullptr, salida + i, n - i, tablas);
+}
+
+__attribute__((target("avx2")))
+static void planosBitsAvx2(const unsigned char* bloque, uint64_t* planos) {
+    __m256i bajo = _mm256_loadu_si256((const __m256i*)bloque);
+    __m256i alto = _mm256_loadu_si256((const __m256i*)(bloque + 32));
+    for (int b = 0; b < 8; b++) {
+        __m128i cuenta = _mm_cvtsi32_si128(7 - b);
+        uint64_t planoBajo = (uint32_t)_mm256_movemask_epi8(_mm256_sll_epi16(bajo, cuenta));
+        uint64_t planoAlto = (uint32_t)_mm256_movemask_epi8(_mm256_sll_epi16(alto, cuenta));
+        planos[b] = planoBajo | (planoAlto << 32);
+    }
+}
+
+static const NucleosBytes nucleosAvx2 = {
+    "avx2", xorBytesAvx2, rotarDerechaAvx2, rotarIzquierdaAvx2,
+    desplazarDerechaAvx2, desplazarIzquierdaAvx2, tablasNibblesAvx2, planosBitsAvx2
+};
+
+// ---- AVX-512 (los desplazamientos de 16 bits en 512 bits requieren AVX512BW) ----
+
+__attribute__((target("avx512f,avx512bw")))
+static void xorBytesAvx512(const unsigned char* entrada, const unsigned char* auxiliar, unsigned char* salida, long long n) {
+    long long i = 0;
+    for(; i + 64 <= n; i += 64) {
+        __m512i a = _mm512_loadu_si512((const void*)(entrada + i));
+        __m512i b = _mm512_loadu_si512((const void*)(auxiliar + i));
+        _mm512_storeu_si512((void*)(salida + i), _mm512_xor_si512(a, b));
+    }
+    xorBytesEscalar(entrada + i, auxiliar + i, salida + i, n - i);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static void rotarDerechaAvx512(const unsigned char* entrada, unsigned char* salida, long long n, int bits) {
+    __m128i cuentaDer = _mm_cvtsi32_si128(bits);
+    __m128i cuentaIzq = _mm_cvtsi32_si128(8 - bits);
+    __m512i mascaraDer = _mm512_set1_epi8((char)(0xFF >> bits));
+    __m512i mascaraIzq = _mm512_set1_epi8((char)(0xFF << (8 - bits)));
+    long long i = 0;
+    for(; i + 64 <= n; i += 64) {
+        __m512i v = _mm512_loadu_si512((const void*)(entrada + i));
+        __m512i der = _mm512_and_si512(_mm512_srl_epi16(v, cuentaDer), mascaraDer);
+        __m512i izq = _mm512_and_si512(_mm512_sll_epi16(v, cuentaIzq), mascaraIzq);
+        _mm512_storeu_si512((void*)(salida + i), _mm512_or_si512(der, izq));
+    }
+    rotarDerechaEscalar(entrada + i, salida + i, n - i, bits);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static void rotarIzquierdaAvx512(const unsigned char* entrada, unsigned char* salida, long long n, int bits) {
+    rotarDerechaAvx512(entrada, salida, n, (8 - bits) & 7);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static void desplazarDerechaAvx512(const unsigned char* entrada, unsigned char* salida, long long n, int bits) {
+    __m128i cuenta = _mm_cvtsi32_si128(bits);
+    __m512i mascara = _mm512_set1_epi8((char)(0xFF >> bits));
+    long long i = 0;
+    for(; i + 64 <= n; i += 64) {
+        __m512i v = _mm512_loadu_si512((const void*)(entrada + i));
+        _mm512_storeu_si512((void*)(salida + i), _mm512_and_si512(_mm512_srl_epi16(v, cuenta), mascara));
+    }
+    desplazarDerechaEscalar(entrada + i, salida + i, n - i, bits);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static void desplazarIzquierdaAvx512(const unsigned char* entrada, unsigned char* salida, long long n, int bits) {
+    __m128i cuenta = _mm_cvtsi32_si128(bits);
+    __m512i mascara = _mm512_set1_epi8((char)(0xFF << bits));
+    long long i = 0;
+    for(; i + 64 <= n; i += 64) {
+        __m512i v = _mm512_loadu_si512((const void*)(entrada + i));
+        _mm512_storeu_si512((void*)(salida + i), _mm512_and_si512(_mm512_sll_epi16(v, cuenta), mascara));
+    }
+    desplazarIzquierdaEscalar(entrada + i, salida + i, n - i, bits);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static void tablasNibblesAvx512(const unsigned char* entrada, const unsigned char* auxiliar, unsigned char* salida,
+                                long long n, const unsigned char (*tablas)[16]) {
+    __m512i nibble = _mm512_set1_epi8(0x0F);
+    __m512i t[4];
+    for (int k = 0; k < (auxiliar ? 4 : 2); k++) {
+        unsigned char repetida[64]; // pshufb trabaja por carriles de 16 bytes: la tabla va en los cuatro
+        for (int c = 0; c < 4; c++) memcpy(repetida + c * 16, tablas[k], 16);
+        t[k] = _mm512_loadu_si512((const void*)repetida);
+    }
+    long long i = 0;
+    for(; i + 64 <= n; i += 64) {
+        __m512i v = _mm512_loadu_si512((const void*)(entrada + i));
+        __m512i r = _mm512_xor_si512(
+            _mm512_shuffle_epi8(t[0], _mm512_and_si512(v, nibble)),
+            _mm512_shuffle_epi8(t[1], _mm512_and_si512(_mm512_srli_epi16(v, 4), nibble)));
+        if (auxiliar) {
+            __m512i a = _mm512_loadu_si512((const void*)(auxiliar + i));
+            r = _mm512_xor_si512(r, _mm512_xor_si512(
+                _mm512_shuffle_epi8(t[2], _mm512_and_si512(a, nibble)),
+                _mm512_shuffle_epi8(t[3], _mm512_and_si512(_mm512_srli_epi16(a, 4), nibble))));
+        }
+        _mm512_storeu_si512((void*)(salida + i), r);
+    }
+    tablasNibblesEscalar(entrada + i, auxiliar ? auxiliar + i : nullptr, salida + i, n - i, tablas);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static void planosBitsAvx512(const unsigned char* bloque, uint64_t* planos) {
+    __m512i v = _mm512_loadu_si512((const void*)bloque);
+    for (int b = 0; b < 8; b++) {
+        planos[b] = _mm512_movepi8_mask(_mm512_sll_epi16(v, _mm_cvtsi32_si128(7 - b)));
+    }
+}
+
+static const NucleosBytes nucleosAvx512 = {
+    "avx512", xorBytesAvx512, rotarDerechaAvx512, rotarIzquierdaAvx512,
+    desplazarDerechaAvx512, desplazarIzquierdaAvx512, tablasNibblesAvx512, planosBitsAvx512
+};
+#endif
+
+vector<const NucleosBytes*> nucleosDisponibles() {
+    // Ordenados de menor a mayor preferencia; el escalar siempre está
+    vector<const NucleosBytes*> lista = {&nucleosEscalares};
+#ifdef NUCLEOS_SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse2")) lista.push_back(&nucleosSse2);
+    if (__builtin_cpu_supports("avx2")) lista.push_back(&nucleosAvx2);
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")) lista.push_back(&nucleosAvx512);
+#endif
+    return lista;
+}
+
+// Se elige antes de main(), cuando todavía no hay otros hilos
+static const NucleosBytes* nucleosActivos = nucleosDisponibles().back();
+
+const NucleosBytes& nucleos() {
+    return *nucleosActivos;
+}
+
+bool elegirNucleos(const string& nombre) {
+    for (const NucleosBytes* n : nucleosDisponibles()) {
+        if (nombre == n->nombre) {
+            nucleosActivos = n;
+            return true;
+        }
+    }
+    return false;
+}
+
+void aplicarTransformacion(unsigned char* entrada, unsigned char* salida, long long totalPixeles,
+                          Transformacion trans, unsigned char* imagenAuxiliar) {
+    const NucleosBytes& n = nucleos();
+    switch(trans.tipo) {
+        case XOR_CON_IM:
+            if (!imagenAuxiliar) {
+                registro() << "Error: Se requiere imagen auxiliar para XOR" << endl;
+                memcpy(salida, entrada, totalPixeles);
+                return;
+            }
+            n.xorBytes(entrada, imagenAuxiliar, salida, totalPixeles);
+            break;
+        case ROTACION_DERECHA:
+            n.rotarDerecha(entrada, salida, totalPixeles, trans.bits);
+            break;
+        case ROTACION_IZQUIERDA:
+            n.rotarIzquierda(entrada, salida, totalPixeles, trans.bits);
+            break;
+        case DESPLAZAMIENTO_DERECHA:
+            n.desplazarDerecha(entrada, salida, totalPixeles, trans.bits);
+            break;
+        case DESPLAZAMIENTO_IZQUIERDA:
+            n.desplazarIzquierda(entrada, salida, totalPixeles, trans.bits);
+            break;
+        case NINGUNA:
+        default:
+            memcpy(salida, entrada, totalPixeles);
+            break;
+    }
+}
+
+void aplicarTransformacionInversa(unsigned char* entrada, unsigned char* salida, long long totalPixeles,
+                                 Transformacion trans, unsigned char* imagenAuxiliar) {
+    const NucleosBytes& n = nucleos();
+    switch(trans.tipo) {
+        case XOR_CON_IM:
+            if (!imagenAuxiliar) {
+                registro() << "Error: Se requiere imagen auxiliar para XOR" << endl;
+                memcpy(salida, entrada, totalPixeles);
+                return;
+            }
+            n.xorBytes(entrada, imagenAuxiliar, salida, totalPixeles);
+            break;
+        case ROTACION_DERECHA:
+            n.rotarIzquierda(entrada, salida, totalPixeles, trans.bits);  // Inversa de rotación derecha
+            break;
+        case ROTACION_IZQUIERDA:
+            n.rotarDerecha(entrada, salida, totalPixeles, trans.bits);  // Inversa de rotación izquierda
+            break;
+        case DESPLAZAMIENTO_DERECHA:
+            n.desplazarIzquierda(entrada, salida, totalPixeles, trans.bits);  // No es perfectamente inversa
+            break;
+        case DESPLAZAMIENTO_IZQUIERDA:
+            n.desplazarDerecha(entrada, salida, totalPixeles, trans.bits);  // No es perfectamente inversa
+            break;
+        case NINGUNA:
+        default:
+            memcpy(salida, entrada, totalPixeles);
+            break;
+    }
+}
+
+void componerIdentidad(TransformacionCompuesta& compuesta) {
+    for (int v = 0; v < 256; v++) {
+        compuesta.tabla[v] = v;
+        compuesta.tablaAuxiliar[v] = 0;
+    }
+}
+
+void componerTransformacion(TransformacionCompuesta& compuesta, Transformacion trans) {
+    // compuesta := trans después de compuesta
+    if (trans.tipo == XOR_CON_IM) {
+        for (int v = 0; v < 256; v++) compuesta.tablaAuxiliar[v] ^= v;
+        return;
+    }
+    // Mapa por byte (lineal): se aplica a ambas tablas
+    for (int v = 0; v < 256; v++) {
+        compuesta.tabla[v] = transformarByte(compuesta.tabla[v], trans, 0);
+        compuesta.tablaAuxiliar[v] = transformarByte(compuesta.tablaAuxiliar[v], trans, 0);
+    }
+}
+
+void componerInversa(TransformacionCompuesta& compuesta, Transformacion trans) {
+    // La inversa de cada paso es otra transformación del mismo conjunto (los desplazamientos
+    // se "deshacen" con el desplazamiento contrario, igual que en aplicarTransformacionInversa)
+    Transformacion inversa = trans;
+    switch (trans.tipo) {
+        case ROTACION_DERECHA: inversa.tipo = ROTACION_IZQUIERDA; break;
+        case ROTACION_IZQUIERDA: inversa.tipo = ROTACION_DERECHA; break;
+        case DESPLAZAMIENTO_DERECHA: inversa.tipo = DESPLAZAMIENTO_IZQUIERDA; break;
+        case DESPLAZAMIENTO_IZQUIERDA: inversa.tipo = DESPLAZAMIENTO_DERECHA; break;
+        default: break;
+    }
+    componerTransformacion(compuesta, inversa);
+}
+
+TransformacionCompuesta componerSecuencia(const vector<Transformacion>& secuencia, bool inversa) {
+    // Directa: del primer paso al último. Inversa: deshace del último al primero.
+    TransformacionCompuesta compuesta;
+    componerIdentidad(compuesta);
+    if (inversa) {
+        for (size_t i = secuencia.size(); i-- > 0; ) componerInversa(compuesta, secuencia[i]);
+    } else {
+        for (const Transformacion& t : secuencia) componerTransformacion(compuesta, t);
+    }
+    return compuesta;
+}
+
+void materializarPaso(const vector<Transformacion>& secuencia, int paso, const unsigned char* imagenFinal,
+                      const unsigned char* imagenAuxiliar, unsigned char* salida, long long totalPixeles) {
+    // Imagen tal como estaba después de los primeros 'paso' pasos de la secuencia, obtenida
+    // desde la imagen final deshaciendo el resto en una sola pasada
+    vector<Transformacion> resto(secuencia.begin() + min<size_t>(paso, secuencia.size()), secuencia.end());
+    aplicarCompuesta(componerSecuencia(resto, true), imagenFinal, imagenAuxiliar, salida, totalPixeles);
+}
+
+static bool esLineal(const unsigned char* tabla) {
+    // Una tabla es lineal si tabla[v] = tabla[nibble bajo] ^ tabla[nibble alto] para todo v
+    for (int v = 0; v < 256; v++) {
+        if (tabla[v] != (tabla[v & 0x0F] ^ tabla[v & 0xF0])) return false;
+    }
+    return true;
+}
+
+void aplicarCompuesta(const TransformacionCompuesta& compuesta, const unsigned char* entrada,
+                      const unsigned char* imagenAuxiliar, unsigned char* salida, long long totalPixeles) {
+    bool usaAuxiliar = false, esIdentidad = true;
+    for (int v = 0; v < 256; v++) {
+        usaAuxiliar = usaAuxiliar || compuesta.tablaAuxiliar[v] != 0;
+        esIdentidad = esIdentidad && compuesta.tabla[v] == v;
+    }
+    if (usaAuxiliar && !imagenAuxiliar) {
+        registro() << "Error: Se requiere imagen auxiliar para XOR" << endl;
+        usaAuxiliar = false;
+    }
+
+    // Casos triviales: copia o un XOR puro (dos XOR con la misma imagen se cancelan solos)
+    if (esIdentidad && !usaAuxiliar) {
+        if (salida != entrada) memcpy(salida, entrada, totalPixeles);
+        return;
+    }
+    bool xorPuro = esIdentidad;
+    for (int v = 0; v < 256 && xorPuro; v++) xorPuro = compuesta.tablaAuxiliar[v] == v;
+    if (xorPuro) {
+        nucleos().xorBytes(entrada, imagenAuxiliar, salida, totalPixeles);
+        return;
+    }
+
+    if (esLineal(compuesta.tabla) && esLineal(compuesta.tablaAuxiliar)) {
+        unsigned char tablas[4][16];
+        for (int v = 0; v < 16; v++) {
+            tablas[0][v] = compuesta.tabla[v];
+            tablas[1][v] = compuesta.tabla[v << 4];
+            tablas[2][v] = compuesta.tablaAuxiliar[v];
+            tablas[3][v] = compuesta.tablaAuxiliar[v << 4];
+        }
+        nucleos().tablasNibbles(entrada, usaAuxiliar ? imagenAuxiliar : nullptr, salida, totalPixeles, tablas);
+        return;
+    }
+
+    // Respaldo general con las tablas completas de 256 entradas
+    for (long long i = 0; i < totalPixeles; i++) {
+        unsigned char v = compuesta.tabla[entrada[i]];
+        salida[i] = usaAuxiliar ? v ^ compuesta.tablaAuxiliar[imagenAuxiliar[i]] : v;
+    }
+}
+
+bool compararImagenes(unsigned char* img1, unsigned char* img2, long long totalPixeles) {
+    // Verificar si las imágenes son similares (pueden haber pequeñas diferencias por redondeo)
+    long long diferencias = 0;
+    int umbralDiferencia = 3;  // Tolerancia para diferencias de valor
+    long long umbralTotalDiferencias = totalPixeles * 0.01;  // Permitir hasta 1% de píxeles diferentes
+
+    for(long long i = 0; i < totalPixeles; i++) {
+        if(abs(img1[i] - img2[i]) > umbralDiferencia) {
+            diferencias++;
+            if(diferencias > umbralTotalDiferencias) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+unsigned char transformarByte(unsigned char valor, Transformacion trans, unsigned char auxiliar) {
+    switch(trans.tipo) {
+        case XOR_CON_IM: return valor ^ auxiliar;
+        case ROTACION_DERECHA: return rotarDerecha(valor, trans.bits);
+        case ROTACION_IZQUIERDA: return rotarIzquierda(valor, trans.bits);
+        case DESPLAZAMIENTO_DERECHA: return desplazarDerecha(valor, trans.bits);
+        case DESPLAZAMIENTO_IZQUIERDA: return desplazarIzquierda(valor, trans.bits);
+        case NINGUNA:
+        default: return valor;
+    }
+}
+
+int contarDiferenciasVentana(const EstadoParcial& despues, const unsigned char* imagenFinal,
+                             const unsigned char* imagenAuxiliar, long long totalPixeles, Transformacion trans, long long semilla,
+                             const uint16_t* sumas, const unsigned char* mascara, int cantidadBytes, int maxDiferencias,
+                             const CancelacionCandidatos* cancelacion, int indice) {
+    // En la ventana el valor previo a la transformación es exacto: suma - máscara. Basta con
+    // aplicarle la transformación directa y compararlo con la imagen posterior, lo que además
+    // funciona con los desplazamientos (que no tienen inversa exacta). La imagen posterior se
+    // obtiene del estado compuesto y solo se comparan los bits que se conocen de ella.
+    // La ventana puede dar la vuelta al final de la imagen: se recorre por tramos contiguos
+    // (uno hasta el final de la imagen y los siguientes desde el principio) con un índice
+    // simple dentro de cada tramo, sin calcular el módulo en cada byte.
+    const unsigned char* tabla = despues.desdeFinal.tabla;
+    const unsigned char* tablaAuxiliar = despues.desdeFinal.tablaAuxiliar;
+    unsigned char conocidos = despues.bitsConocidos;
+    long long inicio = semilla % totalPixeles;
+    int diferencias = 0;
+
+    for(int j = 0; j < cantidadBytes; inicio = 0) {
+        int largoTramo = (int)min<long long>(cantidadBytes - j, totalPixeles - inicio);
+        const unsigned char* finalTramo = imagenFinal + inicio;
+        const unsigned char* auxiliarTramo = imagenAuxiliar ? imagenAuxiliar + inicio : nullptr;
+        for(int k = 0; k < largoTramo; k++, j++) {
+            if (cancelacion && (j & 0xFFF) == 0 && cancelacion->cancelado(indice)) {
+                return INT_MAX;  // Otro candidato anterior ya verificó
+            }
+            int antes = (int)sumas[j] - mascara[j];
+            unsigned char auxiliar = auxiliarTramo ? auxiliarTramo[k] : 0;
+            unsigned char esperado = tabla[finalTramo[k]] ^ tablaAuxiliar[auxiliar];
+
+            if(antes < 0 || antes > 255 || ((transformarByte(antes, trans, auxiliar) ^ esperado) & conocidos) != 0) {
+                diferencias++;
+                if(diferencias > maxDiferencias) {
+                    contarPerfil(CONTADOR_CORTES_TEMPRANOS);
+                    contarPerfil(CONTADOR_BYTES_RECORRIDOS, j + 1);
+                    return diferencias;  // Ya no puede ser válida, no hace falta seguir
+                }
+            }
+        }
+    }
+
+    contarPerfil(CONTADOR_BYTES_RECORRIDOS, cantidadBytes);
+    return diferencias;
+}
+
+long long contarDiferenciasIdaVuelta(const EstadoParcial& despues, const unsigned char* imagenFinal,
+                                     const unsigned char* imagenAuxiliar, long long totalPixeles, Transformacion trans,
+                                     long long maxDiferencias) {
+    // Cuenta los bytes que cambiarían al aplicar la inversa y luego la directa a toda la
+    // imagen, sin buffers intermedios: para un desplazamiento, ida y vuelta solo cambia los
+    // bytes que tienen encendidos los bits que el desplazamiento habría perdido (los altos en
+    // uno a la derecha, los bajos en uno a la izquierda). XOR y rotaciones son biyectivas y
+    // nunca cambian nada. Los bits que ya son desconocidos en el estado no se pueden usar.
+    // Es más estricto que comparar la ida y vuelta con compararImagenes: cuenta cualquier bit
+    // distinto, sin la tolerancia de 3 en el valor, así que un desplazamiento a la izquierda
+    // de 1 o 2 bits (que cambia el byte en menos de 4) también cuenta como diferencia.
+    unsigned char bitsPerdidos = 0;
+    if (trans.tipo == DESPLAZAMIENTO_DERECHA) {
+        bitsPerdidos = (unsigned char)(0xFF << (8 - trans.bits));
+    } else if (trans.tipo == DESPLAZAMIENTO_IZQUIERDA) {
+        bitsPerdidos = (unsigned char)(0xFF >> (8 - trans.bits));
+    }
+    bitsPerdidos &= despues.bitsConocidos;
+    if (bitsPerdidos == 0) return 0;
+
+    // Tablas ya recortadas a los bits que interesan: el byte difiere si su XOR no es cero
+    unsigned char tabla[256], tablaAuxiliar[256];
+    for (int v = 0; v < 256; v++) {
+        tabla[v] = despues.desdeFinal.tabla[v] & bitsPerdidos;
+        tablaAuxiliar[v] = despues.desdeFinal.tablaAuxiliar[v] & bitsPerdidos;
+    }
+
+    // Se recorre en bloques para que el conteo interno se vectorice y el corte temprano se
+    // evalúe una vez por bloque: un candidato incorrecto cuesta unas pocas líneas de caché.
+    const long long tamBloque = 256;
+    long long diferencias = 0;
+    for(long long inicio = 0; inicio < totalPixeles; inicio += tamBloque) {
+        long long fin = min(inicio + tamBloque, totalPixeles);
+        int enBloque = 0;
+        if (imagenAuxiliar) {
+            for(long long i = inicio; i < fin; i++) {
+                enBloque += (tabla[imagenFinal[i]] ^ tablaAuxiliar[imagenAuxiliar[i]]) != 0;
+            }
+        } else {
+            for(long long i = inicio; i < fin; i++) {
+                enBloque += tabla[imagenFinal[i]] != 0;
+            }
+        }
+        diferencias += enBloque;
+        if(diferencias > maxDiferencias) {
+            contarPerfil(CONTADOR_CORTES_TEMPRANOS);
+            contarPerfil(CONTADOR_BYTES_RECORRIDOS, fin);
+            return diferencias;
+        }
+    }
+    contarPerfil(CONTADOR_BYTES_RECORRIDOS, totalPixeles);
+    return diferencias;
+}
+
+void contarDesplazamientos(const EstadoParcial& despues, const unsigned char* imagenFinal,
+                           const unsigned char* imagenAuxiliar, long long totalPixeles, ConteoDesplazamientos& conteo) {
+    // Lo mismo que contarDiferenciasIdaVuelta para los 14 desplazamientos a la vez: el estado
+    // se reconstruye por tramos, cada bloque de 64 bytes se pasa a planos de bits y los bits
+    // altos/bajos acumulados con OR dan, con un popcount, cuántos bytes perdería cada uno.
+    // Los planos de bits desconocidos se ignoran.
+    TemporizadorFase fase("conteo_desplazamientos");
+    contarPerfil(CONTADOR_BYTES_RECORRIDOS, totalPixeles);
+    memset(&conteo, 0, sizeof(conteo));
+    conteo.bytesImagen = totalPixeles;
+    const NucleosBytes& n = nucleos();
+    const int tamTramo = 4096;
+    unsigned char tramo[tamTramo];
+
+    for (long long inicio = 0; inicio < totalPixeles; inicio += tamTramo) {
+        int enTramo = (int)min<long long>(tamTramo, totalPixeles - inicio);
+        aplicarCompuesta(despues.desdeFinal, imagenFinal + inicio, imagenAuxiliar ? imagenAuxiliar + inicio : nullptr,
+                         tramo, enTramo);
+        if (enTramo % 64) memset(tramo + enTramo, 0, 64 - enTramo % 64);  // Relleno neutro
+
+        for (int base = 0; base < enTramo; base += 64) {
+            uint64_t planos[8];
+            n.planosBits(tramo + base, planos);
+            for (int b = 0; b < 8; b++) {
+                if (!((despues.bitsConocidos >> b) & 1)) planos[b] = 0;
+            }
+            uint64_t altos = 0, bajos = 0;
+            for (int bits = 1; bits < 8; bits++) {
+                altos |= planos[8 - bits];
+                bajos |= planos[bits - 1];
+                conteo.derecha[bits] += contarUnos(altos);
+                conteo.izquierda[bits] += contarUnos(bajos);
+            }
+        }
+    }
+}
+
+void contarDesplazamientosHistograma(const EstadoParcial& despues, const uint64_t* histograma,
+                                     ConteoDesplazamientos& conteo) {
+    // Mismo resultado que contarDesplazamientos a partir del histograma conjunto de la imagen:
+    // todos los bytes con el mismo par (final, auxiliar) valen lo mismo en el estado, así que
+    // alcanza con recorrer los 65536 pares en lugar de la imagen
+    uint64_t porValor[256] = {0};
+    const unsigned char* tabla = despues.desdeFinal.tabla;
+    const unsigned char* tablaAuxiliar = despues.desdeFinal.tablaAuxiliar;
+    for (int f = 0; f < 256; f++) {
+        for (int a = 0; a < 256; a++) {
+            porValor[(tabla[f] ^ tablaAuxiliar[a]) & despues.bitsConocidos] += histograma[f * 256 + a];
+        }
+    }
+
+    memset(&conteo, 0, sizeof(conteo));
+    for (int v = 0; v < 256; v++) {
+        conteo.bytesImagen += (long long)porValor[v];
+        if (!porValor[v]) continue;
+        for (int bits = 1; bits < 8; bits++) {
+            if (v & (0xFF << (8 - bits)) & 0xFF) conteo.derecha[bits] += (long long)porValor[v];
+            if (v & (0xFF >> (8 - bits))) conteo.izquierda[bits] += (long long)porValor[v];
+        }
+    }
+}
+
+void contarDesplazamientosParalelo(PoolHilos& hilos, const EstadoParcial& despues, const unsigned char* imagenFinal,
+                                   const unsigned char* imagenAuxiliar, long long totalPixeles, ConteoDesplazamientos& conteo) {
+    // Cada byte cuenta por separado: la imagen se parte en un tramo contiguo por hilo y los
+    // conteos parciales se suman
+    TemporizadorFase fase("conteo_desplazamientos_paralelo");
+    int partes = hilos.cantidadHilos();
+    long long tamParte = (totalPixeles + partes - 1) / partes;
+    vector<ConteoDesplazamientos> parciales(partes);
+    for (int p = 0; p < partes; p++) {
+        hilos.encolar([&, p]() {
+            long long inicio = min(p * tamParte, totalPixeles);
+            long long largo = min(tamParte, totalPixeles - inicio);
+            contarDesplazamientos(despues, imagenFinal + inicio, imagenAuxiliar ? imagenAuxiliar + inicio : nullptr,
+                                  largo, parciales[p]);
+        });
+    }
+    hilos.esperar();
+
+    memset(&conteo, 0, sizeof(conteo));
+    conteo.bytesImagen = totalPixeles;
+    for (const ConteoDesplazamientos& parcial : parciales) {
+        for (int bits = 1; bits < 8; bits++) {
+            conteo.derecha[bits] += parcial.derecha[bits];
+            conteo.izquierda[bits] += parcial.izquierda[bits];
+        }
+    }
+}
+
+bool verificarCandidato(const EstadoParcial& despues, const unsigned char* imagenFinal,
+                        const unsigned char* imagenAuxiliar, long long totalPixeles, Transformacion trans, long long semilla,
+                        const uint16_t* sumas, const unsigned char* mascara, int cantidadBytes,
+                        const ConteoDesplazamientos* conteo, const CancelacionCandidatos* cancelacion, int indice) {
+    // Núcleo fusionado inversa -> directa -> máscara -> comparación. Primero la ventana de la
+    // máscara (pocos bytes, descarta casi todos los candidatos) y después, solo si hace falta,
+    // la consistencia de ida y vuelta en el resto de la imagen. Ambos usan la tolerancia del
+    // 1% de compararImagenes y se cortan en cuanto la superan.
+    int maxDiferenciasVentana = cantidadBytes * 0.01;
+    if (contarDiferenciasVentana(despues, imagenFinal, imagenAuxiliar, totalPixeles, trans, semilla, sumas, mascara,
+                                 cantidadBytes, maxDiferenciasVentana, cancelacion, indice) > maxDiferenciasVentana) {
+        return false;
+    }
+
+    // Con el conteo ya hecho no se vuelve a mirar la imagen (en el modo por bloques solo se
+    // tiene la ventana): XOR y rotaciones no pierden bits
+    if (conteo) {
+        long long maxDiferenciasConteo = conteo->bytesImagen * 0.01;
+        if (trans.tipo == DESPLAZAMIENTO_DERECHA) return conteo->derecha[trans.bits] <= maxDiferenciasConteo;
+        if (trans.tipo == DESPLAZAMIENTO_IZQUIERDA) return conteo->izquierda[trans.bits] <= maxDiferenciasConteo;
+        return true;
+    }
+    long long maxDiferenciasImagen = totalPixeles * 0.01;
+    return contarDiferenciasIdaVuelta(despues, imagenFinal, imagenAuxiliar, totalPixeles, trans,
+                                      maxDiferenciasImagen) <= maxDiferenciasImagen;
+}
+
+vector<Transformacion> candidatosTransformacion() {
+    // Todas las transformaciones posibles de un paso. Rotar o desplazar 0 bits no cambia la
+    // imagen, así que no se prueba.
+    vector<Transformacion> candidatos;
+    candidatos.push_back({XOR_CON_IM, 0});
+    TipoTransformacion tipos[] = {ROTACION_DERECHA, ROTACION_IZQUIERDA, DESPLAZAMIENTO_DERECHA, DESPLAZAMIENTO_IZQUIERDA};
+    for (TipoTransformacion tipo : tipos) {
+        for (int bits = 1; bits < 8; bits++) {
+            candidatos.push_back({tipo, bits});
+        }
+    }
+    return candidatos;
+}
+
+vector<Transformacion> detectarTransformacion(const EstadoParcial& despues, const unsigned char* imagenFinal,
+                                             const unsigned char* imagenAuxiliar, long long totalPixeles, long long semilla,
+                                             const uint16_t* sumas, const unsigned char* mascara, int cantidadBytes,
+                                             long* descartados) {
+    // Clasificador por planos de bits sobre la ventana de la máscara, donde se conocen el byte
+    // de antes (suma - máscara), el de después y el de la imagen auxiliar. Cada transformación
+    // lleva cada bit de salida j a un bit de entrada fijo (rotación/desplazamiento), a un cero
+    // (bits que entran en un desplazamiento) o al mismo bit XOR la auxiliar. Con una pasada se
+    // cuentan las coincidencias entre planos y de ahí sale, sin aplicar nada, cuántos bits
+    // fallaría cada uno de los candidatos.
+    TemporizadorFase fase("clasificador");
+    contarPerfil(CONTADOR_BYTES_RECORRIDOS, cantidadBytes);
+    const unsigned char* tabla = despues.desdeFinal.tabla;
+    const unsigned char* tablaAuxiliar = despues.desdeFinal.tablaAuxiliar;
+    unsigned char conocidos = despues.bitsConocidos;
+    long long inicio = semilla % totalPixeles;
+    long long primerTramo = min<long long>(cantidadBytes, totalPixeles - inicio);
+
+    int unosAntes[8] = {0}, unosDespues[8] = {0}, unosAmbos[8][8] = {{0}};
+    int coincidenXor[8] = {0};
+    int validos = 0, fueraDeRango = 0;
+
+    // La ventana se recorre en bloques de 64 bytes transpuestos a planos de bits (un uint64_t
+    // por plano): cada conteo del bloque es un popcount en lugar de 64 comparaciones
+    const NucleosBytes& n = nucleos();
+    for (int base = 0; base < cantidadBytes; base += 64) {
+        unsigned char bloqueAntes[64] = {0}, bloqueDespues[64] = {0}, bloqueXor[64] = {0};
+        uint64_t enRango = 0;
+        int enBloque = min(64, cantidadBytes - base);
+        for (int k = 0; k < enBloque; k++) {
+            int j = base + k;
+            long long posicion = (j < primerTramo) ? inicio + j : (j - primerTramo) % totalPixeles;
+            int antes = (int)sumas[j] - mascara[j];
+            if (antes < 0 || antes > 255) {
+                fueraDeRango++;  // Ningún candidato puede explicar este byte
+                continue;
+            }
+            unsigned char auxiliar = imagenAuxiliar ? imagenAuxiliar[posicion] : 0;
+            bloqueAntes[k] = antes;
+            bloqueDespues[k] = tabla[imagenFinal[posicion]] ^ tablaAuxiliar[auxiliar];
+            bloqueXor[k] = antes ^ auxiliar ^ bloqueDespues[k];  // Cero donde coincide con un XOR
+            enRango |= 1ULL << k;
+        }
+        validos += contarUnos(enRango);
+
+        // Los bytes fuera de rango quedan en cero: no suman unos, pero sí hay que sacarlos del XOR
+        uint64_t planosAntes[8], planosDespues[8], planosXor[8];
+        n.planosBits(bloqueAntes, planosAntes);
+        n.planosBits(bloqueDespues, planosDespues);
+        n.planosBits(bloqueXor, planosXor);
+        for (int b = 0; b < 8; b++) {
+            unosAntes[b] += contarUnos(planosAntes[b]);
+            unosDespues[b] += contarUnos(planosDespues[b]);
+            coincidenXor[b] += contarUnos(~planosXor[b] & enRango);
+        }
+        for (int entrada = 0; entrada < 8; entrada++) {
+            for (int salida = 0; salida < 8; salida++) {
+                unosAmbos[entrada][salida] += contarUnos(planosAntes[entrada] & planosDespues[salida]);
+            }
+        }
+    }
+
+    // Bits en los que falla el candidato: por cada bit de salida conocido, los bytes en que
+    // no coincide con la fuente que le asigna la transformación
+    auto fallosBit = [&](Transformacion trans, int salida) {
+        if (trans.tipo == XOR_CON_IM) return validos - coincidenXor[salida];
+        int entrada = -1;
+        switch (trans.tipo) {
+            case ROTACION_DERECHA: entrada = (salida + trans.bits) % 8; break;
+            case ROTACION_IZQUIERDA: entrada = (salida + 8 - trans.bits) % 8; break;
+            case DESPLAZAMIENTO_DERECHA: entrada = salida + trans.bits; if (entrada > 7) entrada = -1; break;
+            case DESPLAZAMIENTO_IZQUIERDA: entrada = salida - trans.bits; break;
+            default: entrada = salida; break;
+        }
+        if (entrada < 0) return unosDespues[salida];  // Debería ser siempre cero
+        int coinciden = validos - unosAntes[entrada] - unosDespues[salida] + 2 * unosAmbos[entrada][salida];
+        return validos - coinciden;
+    };
+
+    // Un byte distinto tiene al menos un bit distinto y como mucho 8: con la tolerancia de
+    // verificarCandidato, más de 8 * maxDiferencias bits distintos ya no puede pasar
+    int maxDiferencias = cantidadBytes * 0.01;
+    vector<pair<int, Transformacion>> puntuados;
+    for (const Transformacion& trans : candidatosTransformacion()) {
+        int fallos = 0;
+        for (int salida = 0; salida < 8; salida++) {
+            if ((conocidos >> salida) & 1) fallos += fallosBit(trans, salida);
+        }
+        if (fueraDeRango > maxDiferencias || fallos > 8 * maxDiferencias) {
+            if (descartados) (*descartados)++;
+            contarPerfil(CONTADOR_CANDIDATOS_DESCARTADOS);
+            continue;
+        }
+        puntuados.push_back(make_pair(fallos, trans));
+    }
+
+    stable_sort(puntuados.begin(), puntuados.end(),
+                [](const pair<int, Transformacion>& a, const pair<int, Transformacion>& b) { return a.first < b.first; });
+    vector<Transformacion> ordenados;
+    for (const auto& p : puntuados) ordenados.push_back(p.second);
+    return ordenados;
+}
+
+EstadoParcial estadoAnterior(const EstadoParcial& despues, Transformacion trans) {
+    // Deshacer 'trans' sobre el estado. Los bits conocidos se mueven con la misma inversa:
+    // tras deshacer un desplazamiento a la derecha, los bits bajos que entran son desconocidos.
+    EstadoParcial antes = despues;
+    componerInversa(antes.desdeFinal, trans);
+    switch (trans.tipo) {
+        case ROTACION_DERECHA: antes.bitsConocidos = rotarIzquierda(despues.bitsConocidos, trans.bits); break;
+        case ROTACION_IZQUIERDA: antes.bitsConocidos = rotarDerecha(despues.bitsConocidos, trans.bits); break;
+        case DESPLAZAMIENTO_DERECHA: antes.bitsConocidos = desplazarIzquierda(despues.bitsConocidos, trans.bits); break;
+        case DESPLAZAMIENTO_IZQUIERDA: antes.bitsConocidos = desplazarDerecha(despues.bitsConocidos, trans.bits); break;
+        default: break;
+    }
+    return antes;
+}
+
+static void vistaPaso(const BusquedaSecuencia& busqueda, int paso, const unsigned char*& imagenFinal,
+                      const unsigned char*& imagenAuxiliar, long long& totalPixeles, long long& semilla) {
+    // Imágenes sobre las que se verifica el paso. En el modo por bloques solo está la ventana
+    // del paso, ya extraída desde la semilla.
+    imagenFinal = busqueda.imagenFinal;
+    imagenAuxiliar = busqueda.imagenAuxiliar;
+    totalPixeles = busqueda.totalPixeles;
+    semilla = busqueda.restricciones[paso - 1]->semilla;
+    if (busqueda.histograma) {
+        imagenFinal = busqueda.ventanasFinal[paso - 1];
+        imagenAuxiliar = busqueda.ventanasAuxiliar[paso - 1];
+        totalPixeles = busqueda.bytesVentana[paso - 1];
+        semilla = 0;
+    }
+}
+
+int bytesVentanaPaso(const CasoEnMemoria& caso, int paso) {
+    // Bytes de la ventana que restringe Mk.txt: los de sus tripletas, sin pasar del tamaño de M
+    const RestriccionMascara* datos = caso.restricciones[paso];
+    return datos ? (int)min(datos->cantidad * 3LL, caso.bytesMascara) : 0;
+}
+
+static const RestriccionMascara* restriccionPaso(const BusquedaSecuencia& busqueda, int paso) {
+    // Un Mk.txt sin tripletas o una M vacía dejan una ventana de 0 bytes, que no restringe
+    // nada: el paso se trata igual que si faltara su Mk.txt
+    return busqueda.bytesVentana[paso - 1] > 0 ? busqueda.restricciones[paso - 1] : nullptr;
+}
+
+static void prepararBusqueda(const CasoEnMemoria& caso, BusquedaSecuencia& busqueda) {
+    static_cast<CasoEnMemoria&>(busqueda) = caso;
+    busqueda.bytesVentana.assign(caso.restricciones.size(), 0);
+    int ventanaMayor = 0;
+    for (int i = 0; i < (int)caso.restricciones.size(); i++) {
+        busqueda.bytesVentana[i] = bytesVentanaPaso(caso, i);
+        ventanaMayor = max(ventanaMayor, busqueda.bytesVentana[i]);
+    }
+    // Los hilos solo compensan con imágenes o ventanas grandes. El pool se conserva entre
+    // llamadas desde el mismo hilo: un trabajador que resuelve casos en lote lo crea una vez.
+    static thread_local unique_ptr<PoolHilos> poolDelHilo;
+    if (caso.hilos > 1 && (caso.totalPixeles >= UMBRAL_IMAGEN_PARALELA || ventanaMayor >= UMBRAL_VENTANA_PARALELA)) {
+        if (!poolDelHilo || poolDelHilo->cantidadHilos() != caso.hilos) poolDelHilo.reset(new PoolHilos(caso.hilos));
+        busqueda.pool = poolDelHilo.get();
+    }
+}
+
+bool detectarSecuencia(const CasoEnMemoria& caso, ResultadoSecuencia& resultado) {
+    BusquedaSecuencia busqueda;
+    prepararBusqueda(caso, busqueda);
+
+    EstadoParcial estadoFinal;
+    componerIdentidad(estadoFinal.desdeFinal);
+    estadoFinal.bitsConocidos = 0xFF;
+    bool encontrada = buscarSecuencia(busqueda, (int)caso.restricciones.size(), estadoFinal);
+    resultado.secuencia = encontrada ? busqueda.secuencia : busqueda.mejorParcial;
+    // Los pasos sin Mk.txt se saltean en la búsqueda: la secuencia cumple las máscaras que hay,
+    // pero no está completa
+    resultado.completa = encontrada;
+    for (const Transformacion& trans : resultado.secuencia) {
+        if (trans.tipo == NINGUNA) resultado.completa = false;
+    }
+    resultado.estados = busqueda.nodos;
+    resultado.candidatosVerificados = busqueda.candidatosProbados;
+    resultado.candidatosDescartados = busqueda.candidatosDescartados;
+    resultado.podasMemo = busqueda.podasMemo;
+    return resultado.completa;
+}
+
+bool verificarSecuencia(const CasoEnMemoria& caso, const vector<Transformacion>& secuencia) {
+    // Comprueba una secuencia ya conocida (la de la caché) con la misma verificación de la
+    // búsqueda, de la última transformación a la primera. Los pasos sin identificar del
+    // principio de una secuencia incompleta no se pueden comprobar.
+    BusquedaSecuencia busqueda;
+    prepararBusqueda(caso, busqueda);
+    EstadoParcial estado;
+    componerIdentidad(estado.desdeFinal);
+    estado.bitsConocidos = 0xFF;
+    for (int paso = (int)secuencia.size(); paso >= 1; paso--) {
+        Transformacion trans = secuencia[paso - 1];
+        if (trans.tipo == NINGUNA) break;
+        const RestriccionMascara* datos = restriccionPaso(busqueda, paso);
+        if (datos) {
+            const unsigned char* imagenFinal;
+            const unsigned char* imagenAuxiliar;
+            long long totalPixeles;
+            long long semilla;
+            vistaPaso(busqueda, paso, imagenFinal, imagenAuxiliar, totalPixeles, semilla);
+            ConteoDesplazamientos conteo;
+            if (busqueda.histograma) contarDesplazamientosHistograma(estado, busqueda.histograma, conteo);
+            if (!verificarCandidato(estado, imagenFinal, imagenAuxiliar, totalPixeles, trans, semilla, datos->sumas,
+                                    busqueda.mascara, busqueda.bytesVentana[paso - 1],
+                                    busqueda.histograma ? &conteo : nullptr)) {
+                return false;
+            }
+        }
+        estado = estadoAnterior(estado, trans);
+    }
+    return true;
+}
+
+bool buscarSecuencia(BusquedaSecuencia& busqueda, int paso, const EstadoParcial& estado) {
+    // 'estado' es la imagen después del paso 'paso' (1..n); falta determinar los pasos 1..paso
+    if ((int)busqueda.secuencia.size() != (int)busqueda.restricciones.size()) {
+        busqueda.secuencia.assign(busqueda.restricciones.size(), Transformacion{NINGUNA, 0});
+        busqueda.fallidos.assign(busqueda.restricciones.size() + 1, unordered_set<string>());
+        busqueda.pasoMasProfundo = paso;
+        busqueda.mejorParcial = busqueda.secuencia;
+    }
+    busqueda.nodos++;
+
+    if (paso < busqueda.pasoMasProfundo) {
+        busqueda.pasoMasProfundo = paso;
+        busqueda.mejorParcial = busqueda.secuencia;
+    }
+    if (paso == 0) return true;
+
+    // Clave del estado: las dos tablas y los bits conocidos
+    string clave((const char*)&estado.desdeFinal, sizeof(estado.desdeFinal));
+    clave.push_back((char)estado.bitsConocidos);
+    if (busqueda.fallidos[paso].count(clave)) {
+        busqueda.podasMemo++;
+        return false;
+    }
+
+    const RestriccionMascara* datos = restriccionPaso(busqueda, paso);
+    if (!datos) {
+        // Sin Mk.txt (o con su ventana vacía) el paso no se puede determinar: se deja sin
+        // identificar y se sigue
+        busqueda.secuencia[paso - 1] = {NINGUNA, 0};
+        if (buscarSecuencia(busqueda, paso - 1, estado)) return true;
+    } else {
+        const unsigned char* imagenFinal;
+        const unsigned char* imagenAuxiliar;
+        long long totalPixeles;
+        long long semilla;
+        vistaPaso(busqueda, paso, imagenFinal, imagenAuxiliar, totalPixeles, semilla);
+
+        // El clasificador ordena los candidatos por compatibilidad con la ventana y deja fuera
+        // los imposibles: casi siempre el primero es el correcto y se verifica uno solo
+        vector<Transformacion> candidatos = detectarTransformacion(
+            estado, imagenFinal, imagenAuxiliar, totalPixeles, semilla,
+            datos->sumas, busqueda.mascara, busqueda.bytesVentana[paso - 1], &busqueda.candidatosDescartados);
+        // Si quedan al menos dos desplazamientos, la comprobación sobre toda la imagen se hace
+        // una sola vez para todas las cantidades de bits. Con el histograma es siempre así.
+        int desplazamientos = 0;
+        for (const Transformacion& trans : candidatos) {
+            desplazamientos += trans.tipo == DESPLAZAMIENTO_DERECHA || trans.tipo == DESPLAZAMIENTO_IZQUIERDA;
+        }
+        // Con hilos e imagen grande el conteo se reparte por tramos y se usa para cualquier
+        // cantidad de desplazamientos.
+        ConteoDesplazamientos conteo;
+        bool conteoParalelo = busqueda.pool && !busqueda.histograma && desplazamientos > 0 &&
+                              busqueda.totalPixeles >= UMBRAL_IMAGEN_PARALELA;
+        bool usarConteo = desplazamientos > 1 || conteoParalelo || (busqueda.histograma && desplazamientos > 0);
+        if (usarConteo && busqueda.histograma) {
+            contarDesplazamientosHistograma(estado, busqueda.histograma, conteo);
+        } else if (conteoParalelo) {
+            contarDesplazamientosParalelo(*busqueda.pool, estado, busqueda.imagenFinal, busqueda.imagenAuxiliar,
+                                          busqueda.totalPixeles, conteo);
+        } else if (usarConteo) {
+            contarDesplazamientos(estado, busqueda.imagenFinal, busqueda.imagenAuxiliar, busqueda.totalPixeles, conteo);
+        }
+
+        // Con hilos y una ventana grande los candidatos se verifican a la vez. Los resultados se
+        // consumen después en el orden del clasificador, igual que en serie, así que el ganador
+        // es el mismo. Los posteriores al primero que verifica se cancelan; si luego hubiera que
+        // volver atrás hasta ellos, se verifican en ese momento.
+        enum { SIN_EVALUAR, VALIDO, INVALIDO };
+        vector<int> resultados(candidatos.size(), SIN_EVALUAR);
+        if (busqueda.pool && candidatos.size() > 1 && busqueda.bytesVentana[paso - 1] >= UMBRAL_VENTANA_PARALELA) {
+            CancelacionCandidatos cancelacion;
+            for (int i = 0; i < (int)candidatos.size(); i++) {
+                busqueda.pool->encolar([&, i]() {
+                    if (cancelacion.cancelado(i)) return;
+                    if (verificarCandidato(estado, imagenFinal, imagenAuxiliar, totalPixeles, candidatos[i], semilla,
+                                           datos->sumas, busqueda.mascara, busqueda.bytesVentana[paso - 1],
+                                           usarConteo ? &conteo : nullptr, &cancelacion, i)) {
+                        cancelacion.validar(i);
+                        resultados[i] = VALIDO;
+                    } else if (!cancelacion.cancelado(i)) {
+                        resultados[i] = INVALIDO;
+                    }
+                });
+            }
+            busqueda.pool->esperar();
+        }
+
+        for (int i = 0; i < (int)candidatos.size(); i++) {
+            const Transformacion& trans = candidatos[i];
+            busqueda.candidatosProbados++;
+            contarPerfil(CONTADOR_CANDIDATOS_VERIFICADOS);
+            if (busqueda.alProbar) busqueda.alProbar(paso, trans, estado);
+            bool valido = resultados[i] == VALIDO;
+            if (resultados[i] == SIN_EVALUAR) {
+                valido = verificarCandidato(estado, imagenFinal, imagenAuxiliar, totalPixeles,
+                                            trans, semilla, datos->sumas, busqueda.mascara,
+                                            busqueda.bytesVentana[paso - 1], usarConteo ? &conteo : nullptr);
+            }
+            if (!valido) continue;
+            busqueda.secuencia[paso - 1] = trans;
+            if (buscarSecuencia(busqueda, paso - 1, estadoAnterior(estado, trans))) return true;
+        }
+    }
+
+    busqueda.secuencia[paso - 1] = {NINGUNA, 0};
+    busqueda.fallidos[paso].insert(clave);
+    return false;
+}
+
+void aplicarEnmascaramiento(unsigned char* imagen, long long totalPixeles, const RestriccionMascara& datos) {
+    for(int i = 0; i < datos.cantidad * 3; i++) {
+        long long posicion = ((long long)datos.semilla + i) % totalPixeles;
+        imagen[posicion] = imagen[posicion] + datos.sumas[i];
+    }
+}
+
+string nombreTransformacion(Transformacion t) {
+    switch (t.tipo) {
+        case XOR_CON_IM: return "xor";
+        case ROTACION_DERECHA: return "rotacion_derecha/" + to_string(t.bits);
+        case ROTACION_IZQUIERDA: return "rotacion_izquierda/" + to_string(t.bits);
+        case DESPLAZAMIENTO_DERECHA: return "desplazamiento_derecha/" + to_string(t.bits);
+        case DESPLAZAMIENTO_IZQUIERDA: return "desplazamiento_izquierda/" + to_string(t.bits);
+        default: return "ninguna";
+    }
+}
@@ -0,0 +1,120 @@
+#ifndef RECONSTRUCCION_H
+#define RECONSTRUCCION_H
+
+// Núcleo de la reconstrucción: detección de la secuencia de transformaciones y reconstrucción de
+// la imagen original sobre buffers en memoria. No depende de Qt ni del sistema de archivos y no
+// copia ni reserva imágenes: todos los píxeles y máscaras los aporta el llamador. La aplicación
+// de línea de comandos (ProjectParams.pro) solo carga los archivos de cada caso y la llama.
+// Este es el encabezado público; las piezas internas de la búsqueda (núcleos, perfilador,
+// pool de hilos) están en reconstruccion_interna.h.
+
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+// Definición de posibles transformaciones
+enum TipoTransformacion {
+    XOR_CON_IM,
+    ROTACION_DERECHA,
+    ROTACION_IZQUIERDA,
+    DESPLAZAMIENTO_DERECHA,
+    DESPLAZAMIENTO_IZQUIERDA,
+    NINGUNA // Para casos especiales
+};
+
+// Estructura para almacenar información de transformación
+struct Transformacion {
+    TipoTransformacion tipo;
+    int bits; // Número de bits para rotación/desplazamiento
+};
+
+// Composición de una secuencia de transformaciones en una sola pasada. Rotar y desplazar son
+// lineales sobre los bits del byte (f(a ^ b) = f(a) ^ f(b)), así que un XOR con la imagen
+// auxiliar se puede "subir" a través de ellas: cualquier secuencia queda como
+//     salida = tabla[entrada] ^ tablaAuxiliar[auxiliar]
+// y al ser ambas tablas lineales, cada una se descompone en dos tablas de 16 entradas (nibble
+// bajo y nibble alto), que es lo que aplican los núcleos con pshufb.
+struct TransformacionCompuesta {
+    unsigned char tabla[256];          // Mapa aplicado al byte de la imagen
+    unsigned char tablaAuxiliar[256];  // XOR acumulado: mapa aplicado al byte de la imagen auxiliar
+};
+
+// Estado de la imagen en un paso intermedio, expresado respecto de la imagen final: el byte i
+// vale desdeFinal.tabla[final[i]] ^ desdeFinal.tablaAuxiliar[auxiliar[i]] en los bits de
+// 'bitsConocidos'. Los bits que descartó un desplazamiento no se pueden recuperar y quedan
+// como desconocidos; al ser todas las operaciones permutaciones o corrimientos de bits, el
+// conjunto de bits desconocidos es el mismo para todos los bytes.
+struct EstadoParcial {
+    TransformacionCompuesta desdeFinal;
+    unsigned char bitsConocidos;
+};
+
+// Restricción de un paso, el contenido de un Mk.txt: la ventana de la imagen de antes de la
+// transformación k+1 que empieza en 'semilla', sumada byte a byte con la máscara M. Las sumas
+// (imagen + máscara) nunca pasan de 510, así que se guardan en 16 bits.
+struct RestriccionMascara {
+    long long semilla = 0;            // Posición en la imagen: puede pasar de 2^31 en imágenes grandes
+    int cantidad = 0;                 // Cantidad de tripletas RGB
+    const uint16_t* sumas = nullptr;  // cantidad * 3 valores
+};
+
+// Un caso en memoria, tal como lo entrega el llamador. Las imágenes son RGB de totalPixeles
+// bytes (ancho * alto * 3) y la máscara M, RGB de bytesMascara bytes. Nada se copia: los
+// punteros tienen que seguir siendo válidos mientras dure la llamada.
+struct CasoEnMemoria {
+    const unsigned char* imagenFinal = nullptr;     // I_D, la imagen transformada
+    const unsigned char* imagenAuxiliar = nullptr;  // I_M, la imagen del XOR
+    long long totalPixeles = 0;                      // 64 bits: una imagen puede pasar de 2 GB
+    const unsigned char* mascara = nullptr;
+    long long bytesMascara = 0;
+    // Índice k: Mk.txt (nullptr si falta). Hay tantos pasos como elementos: con M0..M6 son 7
+    std::vector<const RestriccionMascara*> restricciones;
+
+    // Modo por bloques: en lugar de las imágenes completas (imagenFinal e imagenAuxiliar no se
+    // usan) se tiene la ventana de cada paso (bytesVentanaPaso bytes desde la semilla) y el
+    // histograma conjunto de toda la imagen
+    const uint64_t* histograma = nullptr;       // 256 x 256, índice final * 256 + auxiliar
+    std::vector<const unsigned char*> ventanasFinal;
+    std::vector<const unsigned char*> ventanasAuxiliar;
+
+    // Hilos para repartir el trabajo de un paso dentro del caso (1 = todo en serie). La
+    // biblioteca crea los suyos y solo los usa con imágenes o ventanas grandes
+    int hilos = 1;
+
+    // Se llama con cada candidato antes de verificarlo (volcados de diagnóstico)
+    std::function<void(int paso, Transformacion trans, const EstadoParcial& estado)> alProbar;
+};
+
+// Resultado de detectarSecuencia
+struct ResultadoSecuencia {
+    // Del primer al último paso. Si ninguna secuencia cumple todas las máscaras es el sufijo
+    // más largo que sí las cumple, y los pasos anteriores quedan en NINGUNA. Un paso sin
+    // restricción (sin Mk.txt, o con un Mk.txt sin tripletas o una M vacía) también queda en
+    // NINGUNA aunque el resto cumpla sus máscaras.
+    std::vector<Transformacion> secuencia;
+    bool completa = false;  // Todos los pasos identificados y todas las máscaras cumplidas
+    long estados = 0;
+    long candidatosVerificados = 0;
+    long candidatosDescartados = 0;  // Descartados por el clasificador sin verificar
+    long podasMemo = 0;              // Estados repetidos que no se volvieron a explorar
+};
+
+// API en memoria. detectarSecuencia busca la secuencia y devuelve si es completa;
+// verificarSecuencia comprueba contra las máscaras una secuencia ya conocida, y
+// materializarPaso (paso 0) escribe la imagen original reconstruida en el buffer del llamador.
+// bytesVentanaPaso es el tamaño de la ventana de un paso, para armar las del modo por bloques.
+bool detectarSecuencia(const CasoEnMemoria& caso, ResultadoSecuencia& resultado);
+bool verificarSecuencia(const CasoEnMemoria& caso, const std::vector<Transformacion>& secuencia);
+int bytesVentanaPaso(const CasoEnMemoria& caso, int paso);
+void materializarPaso(const std::vector<Transformacion>& secuencia, int paso, const unsigned char* imagenFinal,
+const unsigned char* imagenAuxiliar, unsigned char* salida, long long totalPixeles);
+std::string nombreTransformacion(Transformacion t);
+
+// Flujo donde escribe sus mensajes la biblioteca cuando se la llama desde este hilo. Por
+// defecto ninguno (nullptr): la biblioteca no escribe nada salvo que el llamador lo pida.
+// Devuelve el flujo anterior, para restaurarlo.
+std::ostream* establecerRegistro(std::ostream* flujo);
+
+#endif // RECONSTRUCCION_H
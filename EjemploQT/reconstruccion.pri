@@ -0,0 +1,5 @@
+# Núcleo de la reconstrucción sin Qt (API pública en reconstruccion.h). Lo incluyen la aplicación
+# de línea de comandos y la biblioteca estática para integrarlo en otros programas (Reconstruccion.pro)
+INCLUDEPATH += $$PWD
+HEADERS += $$PWD/reconstruccion.h $$PWD/reconstruccion_interna.h
+SOURCES += $$PWD/reconstruccion.cpp
@@ -0,0 +1,214 @@
+#ifndef RECONSTRUCCION_INTERNA_H
+#define RECONSTRUCCION_INTERNA_H
+
+// Piezas internas de la biblioteca de reconstrucción: núcleos SIMD, búsqueda, perfilador y pool
+// de hilos. No son parte de la API en memoria (reconstruccion.h); las usan la propia biblioteca
+// y la aplicación de línea de comandos para el benchmark, el generador y los informes.
+
+#include "reconstruccion.h"
+
+#include <atomic>
+#include <climits>
+#include <condition_variable>
+#include <mutex>
+#include <ostream>
+#include <queue>
+#include <thread>
+#include <unordered_set>
+
+// Núcleos de las operaciones por byte sobre un bloque de n bytes. La versión escalar es la
+// referencia; las versiones SSE2/AVX2/AVX-512 se eligen en tiempo de ejecución según la CPU.
+// La entrada y la salida pueden ser el mismo buffer.
+struct NucleosBytes {
+    const char* nombre;
+    void (*xorBytes)(const unsigned char* entrada, const unsigned char* auxiliar, unsigned char* salida, long long n);
+    void (*rotarDerecha)(const unsigned char* entrada, unsigned char* salida, long long n, int bits);
+    void (*rotarIzquierda)(const unsigned char* entrada, unsigned char* salida, long long n, int bits);
+    void (*desplazarDerecha)(const unsigned char* entrada, unsigned char* salida, long long n, int bits);
+    void (*desplazarIzquierda)(const unsigned char* entrada, unsigned char* salida, long long n, int bits);
+    // salida = t[0][e & 15] ^ t[1][e >> 4] ^ t[2][a & 15] ^ t[3][a >> 4] (sin auxiliar, solo t[0] y t[1])
+    void (*tablasNibbles)(const unsigned char* entrada, const unsigned char* auxiliar, unsigned char* salida,
+                          long long n, const unsigned char (*tablas)[16]);
+    // Transpone un bloque de 64 bytes a 8 planos de bits: el bit k de planos[b] es el bit b del byte k
+    void (*planosBits)(const unsigned char* bloque, uint64_t* planos);
+};
+
+// Bytes de un estado cuyos bits perdería cada desplazamiento, calculados todos en una sola
+// pasada por planos de bits. Índice = cantidad de bits (1..7); el 0 no se usa.
+struct ConteoDesplazamientos {
+    long long derecha[8];    // Bytes con alguno de los 'bits' bits altos encendidos
+    long long izquierda[8];  // Bytes con alguno de los 'bits' bits bajos encendidos
+    long long bytesImagen;   // Bytes contados (la imagen completa), base de la tolerancia del 1%
+};
+
+// Cancelación cooperativa de los candidatos de un paso verificados en paralelo: el candidato
+// 'indice' (posición en el orden del clasificador) deja de calcular en cuanto uno anterior ya
+// verificó, porque en serie nunca se habría llegado a probarlo
+struct CancelacionCandidatos {
+    std::atomic<int> primerValido{INT_MAX};
+    bool cancelado(int indice) const { return primerValido.load(std::memory_order_relaxed) < indice; }
+    void validar(int indice) {
+        int actual = primerValido.load();
+        while (indice < actual && !primerValido.compare_exchange_weak(actual, indice)) {}
+    }
+};
+
+// Pool de hilos de trabajo para procesar varios casos a la vez. Si quien encola tiene un
+// perfilador activo, los contadores de la tarea se acumulan en el trabajador y esperar() los
+// suma al perfilador de quien espera (las fases de la tarea no se registran).
+class PoolHilos {
+public:
+    explicit PoolHilos(int numHilos);
+    ~PoolHilos();
+    void encolar(std::function<void()> tarea);
+    void esperar(); // Bloquea hasta que no queden tareas pendientes ni en ejecución
+    int cantidadHilos() const { return (int)hilos.size(); }
+
+private:
+    struct Tarea {
+        std::function<void()> funcion;
+        bool medir;  // Quien la encoló tenía un perfilador activo
+    };
+    void bucleTrabajador();
+
+    std::vector<std::thread> hilos;
+    std::queue<Tarea> tareas;
+    std::vector<long long> contadoresTareas;  // Por ContadorPerfil, de las tareas ya terminadas
+    std::mutex mtx;
+    std::condition_variable hayTarea;
+    std::condition_variable sinPendientes;
+    int pendientes = 0;
+    bool detener = false;
+};
+
+// Búsqueda en profundidad de la secuencia de transformaciones, del último paso al primero.
+// Mk.txt restringe la imagen de antes del paso k+1, así que cada candidato se comprueba
+// contra su máscara apenas se elige y las ramas que no la cumplen se descartan en el acto.
+// Los estados ya explorados sin éxito se recuerdan por paso: si otro camino llega al mismo
+// estado compuesto (por ejemplo, dos rotaciones que se compensan) no se vuelve a explorar.
+struct BusquedaSecuencia : CasoEnMemoria {
+    std::vector<int> bytesVentana;
+    PoolHilos* pool = nullptr;  // Con caso.hilos > 1 y un caso grande, el del hilo que busca
+    std::vector<std::unordered_set<std::string>> fallidos;  // Por paso, estados sin solución
+    std::vector<Transformacion> secuencia;                   // Se completa desde el final
+
+    // Estadísticas y mejor solución parcial (el sufijo más largo que cumple sus máscaras)
+    long nodos = 0;
+    long candidatosProbados = 0;
+    long candidatosDescartados = 0;             // Descartados por el clasificador sin verificar
+    long podasMemo = 0;
+    int pasoMasProfundo = 0;
+    std::vector<Transformacion> mejorParcial;
+};
+
+// A partir de qué tamaño se reparte el trabajo de un paso entre los hilos del caso (por debajo
+// cuesta más coordinar los hilos que hacer el cálculo en serie)
+const int UMBRAL_IMAGEN_PARALELA = 1 << 20;   // Bytes de imagen para el conteo por tramos
+const int UMBRAL_VENTANA_PARALELA = 1 << 16;  // Bytes de ventana para verificar candidatos a la vez
+
+// Contadores de la instrumentación (--perfil / --traza)
+enum ContadorPerfil {
+    CONTADOR_CANDIDATOS_VERIFICADOS,
+    CONTADOR_CANDIDATOS_DESCARTADOS,  // Descartados por el clasificador sin verificar
+    CONTADOR_CORTES_TEMPRANOS,        // Verificaciones cortadas al superar la tolerancia
+    CONTADOR_BYTES_RECORRIDOS,        // Bytes de imagen leídos por verificación y conteos
+    CONTADOR_BYTES_ES,                // Bytes de imagen cargados y guardados
+    CONTADOR_RESERVAS,                // Buffers nuevos pedidos al sistema
+    CONTADOR_RESERVAS_REUTILIZADAS,   // Buffers servidos por el PoolBuffers
+    CONTADOR_RESERVAS_PAGINAS_ENORMES, // Buffers nuevos que se obtuvieron en páginas enormes
+    CONTADOR_IMAGENES_VOLCADAS,       // Imágenes de diagnóstico encoladas
+    NUM_CONTADORES
+};
+
+// Mediciones de un caso: fases con su inicio y duración, y contadores. Solo se registra algo
+// si el hilo tiene un perfilador activo (perfiladorActual); si no, cada punto de medición se
+// reduce a comparar un puntero con nullptr.
+class Perfilador {
+public:
+    struct Fase {
+        const char* nombre;
+        double inicioUs;   // Desde el arranque del programa
+        double duracionUs;
+    };
+
+    void registrarFase(const char* nombre, double inicioUs, double duracionUs);
+    void contar(ContadorPerfil contador, long long cantidad) { contadores[contador] += cantidad; }
+    const std::vector<Fase>& obtenerFases() const { return fases; }
+    long long valor(ContadorPerfil contador) const { return contadores[contador]; }
+    static const char* nombreContador(ContadorPerfil contador);
+
+private:
+    std::vector<Fase> fases;
+    long long contadores[NUM_CONTADORES] = {0};
+};
+
+extern thread_local Perfilador* perfiladorActual;
+
+inline void contarPerfil(ContadorPerfil contador, long long cantidad = 1) {
+    if (perfiladorActual) perfiladorActual->contar(contador, cantidad);
+}
+
+// Mide el tiempo entre su construcción y su destrucción como una fase del perfilador activo
+class TemporizadorFase {
+public:
+    explicit TemporizadorFase(const char* nombre);
+    ~TemporizadorFase() { terminar(); }
+    void terminar();  // Cierra la fase antes del final del ámbito
+    TemporizadorFase(const TemporizadorFase&) = delete;
+    TemporizadorFase& operator=(const TemporizadorFase&) = delete;
+
+private:
+    const char* nombre;
+    Perfilador* perfilador;
+    double inicioUs = 0;
+};
+
+// Flujo de registro del hilo actual (establecerRegistro); sin flujo, un sumidero que descarta
+std::ostream& registro();
+double microsegundosDesdeInicio();
+
+// Operaciones y pasos de la búsqueda, también usados por el benchmark y el generador de casos
+unsigned char rotarDerecha(unsigned char valor, int bits);
+unsigned char rotarIzquierda(unsigned char valor, int bits);
+unsigned char desplazarDerecha(unsigned char valor, int bits);
+unsigned char desplazarIzquierda(unsigned char valor, int bits);
+void aplicarEnmascaramiento(unsigned char* imagen, long long totalPixeles, const RestriccionMascara& datos);
+void componerIdentidad(TransformacionCompuesta& compuesta);
+void componerTransformacion(TransformacionCompuesta& compuesta, Transformacion trans);
+void componerInversa(TransformacionCompuesta& compuesta, Transformacion trans);
+TransformacionCompuesta componerSecuencia(const std::vector<Transformacion>& secuencia, bool inversa);
+void aplicarCompuesta(const TransformacionCompuesta& compuesta, const unsigned char* entrada,
+const unsigned char* imagenAuxiliar, unsigned char* salida, long long totalPixeles);
+std::vector<const NucleosBytes*> nucleosDisponibles();
+const NucleosBytes& nucleos();
+bool elegirNucleos(const std::string& nombre);
+void aplicarTransformacion(unsigned char* entrada, unsigned char* salida, long long totalPixeles,
+Transformacion trans, unsigned char* imagenAuxiliar = nullptr);
+void aplicarTransformacionInversa(unsigned char* entrada, unsigned char* salida, long long totalPixeles,
+Transformacion trans, unsigned char* imagenAuxiliar = nullptr);
+bool compararImagenes(unsigned char* img1, unsigned char* img2, long long totalPixeles);
+unsigned char transformarByte(unsigned char valor, Transformacion trans, unsigned char auxiliar);
+int contarDiferenciasVentana(const EstadoParcial& despues, const unsigned char* imagenFinal,
+const unsigned char* imagenAuxiliar, long long totalPixeles, Transformacion trans, long long semilla,
+const uint16_t* sumas, const unsigned char* mascara, int cantidadBytes, int maxDiferencias,
+const CancelacionCandidatos* cancelacion = nullptr, int indice = 0);
+long long contarDiferenciasIdaVuelta(const EstadoParcial& despues, const unsigned char* imagenFinal,
+const unsigned char* imagenAuxiliar, long long totalPixeles, Transformacion trans, long long maxDiferencias);
+void contarDesplazamientos(const EstadoParcial& despues, const unsigned char* imagenFinal,
+const unsigned char* imagenAuxiliar, long long totalPixeles, ConteoDesplazamientos& conteo);
+void contarDesplazamientosHistograma(const EstadoParcial& despues, const uint64_t* histograma,
+ConteoDesplazamientos& conteo);
+void contarDesplazamientosParalelo(PoolHilos& hilos, const EstadoParcial& despues, const unsigned char* imagenFinal,
+const unsigned char* imagenAuxiliar, long long totalPixeles, ConteoDesplazamientos& conteo);
+bool verificarCandidato(const EstadoParcial& despues, const unsigned char* imagenFinal,
+const unsigned char* imagenAuxiliar, long long totalPixeles, Transformacion trans, long long semilla,
+const uint16_t* sumas, const unsigned char* mascara, int cantidadBytes,
+const ConteoDesplazamientos* conteo = nullptr, const CancelacionCandidatos* cancelacion = nullptr, int indice = 0);
+std::vector<Transformacion> candidatosTransformacion();
+std::vector<Transformacion> detectarTransformacion(const EstadoParcial& despues, const unsigned char* imagenFinal,
+const unsigned char* imagenAuxiliar, long long totalPixeles, long long semilla, const uint16_t* sumas,
+const unsigned char* mascara, int cantidadBytes, long* descartados = nullptr);
+EstadoParcial estadoAnterior(const EstadoParcial& despues, Transformacion trans);
+bool buscarSecuencia(BusquedaSecuencia& busqueda, int paso, const EstadoParcial& estado);
+
+#endif // RECONSTRUCCION_INTERNA_H
@@ -0,0 +1,104 @@
+// Servicio (--servicio): atiende casos leídos de la entrada estándar hasta EOF
+
+#include <QDir>
+#include <QFileInfo>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <sstream>
+
+#include "aplicacion.h"
+
+using namespace std;
+
+int ejecutarServicio(const OpcionesEjecucion& opciones)
+{
+    // Un trabajo por línea de la entrada estándar ("RUTA_CASO" o "RUTA_CASO<TAB>DIR_SALIDA") y
+    // una línea JSON por trabajo terminado en la salida estándar, en el orden en que terminan.
+    // Los hilos, sus pools de buffers y los núcleos elegidos se mantienen entre trabajos, así
+    // que cada uno paga solo su propio cálculo. El registro de cada caso va a registro.txt en
+    // su directorio de salida para no mezclarse con las respuestas. La respuesta no espera a los
+    // volcados de diagnóstico: si alguno no se pudo escribir, cuando el escritor termina con los
+    // del trabajo sale otra línea {"trabajo": N, "volcados_fallidos": K, "errores": [...]}, que
+    // puede llegar antes o después de la respuesta.
+    int numHilos = opciones.hilos > 0 ? opciones.hilos : (int)thread::hardware_concurrency();
+    numHilos = max(1, numHilos);
+    QString dirSalidaBase = QDir::currentPath() + "/salida";
+    EscritorAsincrono escritor((size_t)opciones.memoriaDiagnosticoMB * 1024 * 1024);
+    PoolHilos pool(numHilos);
+    mutex mtxSalida;
+    cerr << "Servicio listo con " << numHilos << " hilos (núcleos " << nucleos().nombre
+         << "), esperando casos en la entrada estándar" << endl;
+
+    string linea;
+    long numeroTrabajo = 0;
+    while (getline(cin, linea)) {
+        if (!linea.empty() && linea.back() == '\r') linea.pop_back();
+        if (linea.empty()) continue;
+
+        long trabajo = ++numeroTrabajo;
+        size_t tabulador = linea.find('\t');
+        QString rutaCaso = QString::fromStdString(linea.substr(0, tabulador));
+        QString dirSalida = tabulador == string::npos
+                            ? dirSalidaBase + "/" + QFileInfo(rutaCaso).fileName()
+                            : QString::fromStdString(linea.substr(tabulador + 1));
+
+        pool.encolar([&, trabajo, rutaCaso, dirSalida]() {
+            auto inicio = chrono::steady_clock::now();
+            EstadisticasCaso estadisticas;
+            bool existe = QDir(rutaCaso).exists();
+            bool exito = false;
+            if (existe) {
+                ostringstream bufferCaso;
+                ostream* registroAnterior = establecerRegistro(&bufferCaso);
+                exito = reconstruirImagen(rutaCaso, dirSalida, opciones, escritor, &estadisticas,
+                                          [&, trabajo](const VolcadosCaso& volcados) {
+                    if (volcados.fallidos == 0) return;
+                    ostringstream aviso;
+                    aviso << "{\"trabajo\": " << trabajo << ", \"volcados_fallidos\": " << volcados.fallidos
+                          << ", \"errores\": [";
+                    for (size_t i = 0; i < volcados.errores.size(); i++) {
+                        aviso << (i ? ", " : "") << textoJson(volcados.errores[i]);
+                    }
+                    aviso << "]}";
+                    lock_guard<mutex> lock(mtxSalida);
+                    cout << aviso.str() << endl;
+                });
+                establecerRegistro(registroAnterior);
+
+                string texto = bufferCaso.str();
+                QFile archivoRegistro(dirSalida + "/registro.txt");
+                if (archivoRegistro.open(QIODevice::WriteOnly)) archivoRegistro.write(texto.data(), texto.size());
+            }
+            double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - inicio).count();
+
+            ostringstream respuesta;
+            respuesta << "{\"trabajo\": " << trabajo << ", \"caso\": " << textoJson(rutaCaso.toStdString())
+                      << ", \"exito\": " << (exito ? "true" : "false");
+            if (!existe) {
+                respuesta << ", \"error\": \"no existe el directorio del caso\"";
+            } else {
+                respuesta << ", \"salida\": " << textoJson(dirSalida.toStdString())
+                          << ", \"secuencia_completa\": " << (estadisticas.secuenciaCompleta ? "true" : "false")
+                          << ", \"volcados_descartados\": " << estadisticas.volcadosDescartados
+                          << ", \"secuencia\": [";
+                for (size_t i = 0; i < estadisticas.secuencia.size(); i++) {
+                    respuesta << (i ? ", " : "") << textoJson(nombreTransformacion(estadisticas.secuencia[i]));
+                }
+                respuesta << "]";
+            }
+            respuesta << ", \"ms\": " << ms << "}";
+
+            lock_guard<mutex> lock(mtxSalida);
+            cout << respuesta.str() << endl;  // endl: cada respuesta sale en cuanto está lista
+        });
+    }
+
+    pool.esperar();
+    escritor.esperar();  // Los avisos de volcados fallidos usan mtxSalida
+    if (!opciones.traza.isEmpty() && !trazaGlobal.escribir(opciones.traza)) {
+        cerr << "Error: no se pudo escribir la traza en " << opciones.traza.toStdString() << endl;
+    }
+    cerr << "Servicio terminado: " << numeroTrabajo << " trabajos" << endl;
+    return 0;
+}